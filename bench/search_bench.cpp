@@ -0,0 +1,157 @@
+// Times the SearchHelper byte search backends against std::string::find and
+// QString::indexOf on a generated log, and checks that every backend finds
+// the same matches for each option combination, forwards and backwards.
+//
+//   search_bench [MiB]     (default 256)
+//
+// Exits non-zero if the backends disagree.
+
+#include "search_helper.h"
+#include <QElapsedTimer>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+namespace {
+
+// Log-like lines: mostly telemetry, with the needles sprinkled in different
+// cases and next to word and non-word characters, plus some multi-byte UTF-8
+std::string makeLog(qint64 bytes)
+{
+    static const char *const kLines[] = {
+        "[12:00:00.000] TEMP=23.5 HUM=41 PRESS=1013\n",
+        "[12:00:00.010] status ok, Error count 0\n",
+        "[12:00:00.020] motor_error: stall on axis 2\n",
+        "[12:00:00.030] ERROR timeout waiting for ack\n",
+        "[12:00:00.040] errors=3 last=error\n",
+        "[12:00:00.050] température 23,5 °C – capteur ok\n",
+        "[12:00:00.060] x=0.001 y=-0.002 z=9.81\n",
+        "[12:00:00.070] recv 0x7E 0x01 0x02 0x7E error\n",
+    };
+    const int lineCount = int(sizeof(kLines) / sizeof(kLines[0]));
+    std::string text;
+    text.reserve(size_t(bytes) + 64);
+    unsigned seed = 1;
+    while (qint64(text.size()) < bytes) {
+        seed = seed * 1103515245u + 12345u;
+        text += kLines[(seed >> 16) % unsigned(lineCount)];
+    }
+    return text;
+}
+
+// Offsets of every match found by walking forwards (or backwards) through
+// the whole text, one find()/findLast() per match
+QVector<qint64> walk(const std::string &text, const std::string &needle, int options, bool reverse)
+{
+    QVector<qint64> hits;
+    const char *begin = text.data();
+    const char *end = begin + text.size();
+    const int len = int(needle.size());
+    if (!reverse) {
+        for (const char *p = begin; (p = SearchHelper::find(p, end, needle.data(), len, options)); ++p)
+            hits.append(p - begin);
+    } else {
+        for (const char *e = end; (e = SearchHelper::findLast(begin, e, needle.data(), len, options));)
+            hits.append(e - begin);
+    }
+    return hits;
+}
+
+double mibPerSec(qint64 bytes, qint64 ns)
+{
+    return ns > 0 ? double(bytes) / (1024.0 * 1024.0) * 1e9 / double(ns) : 0.0;
+}
+
+QString optionsName(int options)
+{
+    QStringList names;
+    if (options & SearchHelper::CaseInsensitive)
+        names << "nocase";
+    if (options & SearchHelper::WholeWords)
+        names << "words";
+    return names.isEmpty() ? QString("plain") : names.join('+');
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    const qint64 mib = argc > 1 ? qMax(1, atoi(argv[1])) : 256;
+    std::printf("Generating %lld MiB...\n", mib);
+    const std::string text = makeLog(mib * 1024 * 1024);
+    const qint64 size = qint64(text.size());
+
+    const QStringList backends = SearchHelper::backends();
+    std::printf("Backends: %s (default %s)\n", qPrintable(backends.join(", ")), SearchHelper::backendName());
+
+    // Short, first/last byte common, and longer than a SIMD block
+    const char *const kNeedles[] = {"error", "e", "TEMP=23.5 HUM=41 PRESS=1013\n[12:00:00.010] status"};
+    bool ok = true;
+
+    for (const char *needleText : kNeedles) {
+        const std::string needle(needleText);
+        const QString label = QString::fromUtf8(needleText).left(24).replace('\n', "\\n");
+        std::printf("\nNeedle \"%s\"\n", qPrintable(label));
+
+        // Reference: std::string::find, case sensitive
+        QElapsedTimer timer;
+        timer.start();
+        qint64 stdCount = 0;
+        for (size_t p = 0; (p = text.find(needle, p)) != std::string::npos; ++p)
+            ++stdCount;
+        std::printf("  %-24s %8lld matches %9.1f MiB/s\n", "std::string::find", stdCount,
+                    mibPerSec(size, timer.nsecsElapsed()));
+
+        for (int options = 0; options < 4; ++options) {
+            for (bool reverse : {false, true}) {
+                QVector<qint64> expected;
+                QString first;
+                for (const QString &name : backends) {
+                    SearchHelper::setBackend(name);
+                    timer.start();
+                    const QVector<qint64> hits = walk(text, needle, options, reverse);
+                    const qint64 ns = timer.nsecsElapsed();
+                    const QString what = QString("%1 %2 %3").arg(name, optionsName(options),
+                                                                 QString(reverse ? "rev" : "fwd"));
+                    std::printf("  %-24s %8d matches %9.1f MiB/s\n", qPrintable(what), hits.size(),
+                                mibPerSec(size, ns));
+                    if (first.isEmpty()) {
+                        first = name;
+                        expected = hits;
+                    } else if (hits != expected) {
+                        std::printf("  MISMATCH: %s and %s disagree\n", qPrintable(first), qPrintable(name));
+                        ok = false;
+                    }
+                }
+                if (options == 0 && !reverse && expected.size() != stdCount) {
+                    std::printf("  MISMATCH: %d matches, std::string::find found %lld\n", expected.size(),
+                                stdCount);
+                    ok = false;
+                }
+            }
+        }
+    }
+    SearchHelper::setBackend(backends.value(0));
+
+    // What the view searched before the byte search: UTF-16 text and
+    // QString::indexOf. The conversion is not timed.
+    const QString wide = QString::fromUtf8(text.data(), int(qMin<qint64>(size, 0x7fffffff / 2)));
+    const QString term("error");
+    std::printf("\nNeedle \"error\", UTF-16\n");
+    for (Qt::CaseSensitivity cs : {Qt::CaseSensitive, Qt::CaseInsensitive}) {
+        QElapsedTimer timer;
+        timer.start();
+        int count = 0;
+        for (int p = 0; (p = wide.indexOf(term, p, cs)) >= 0; ++p)
+            ++count;
+        std::printf("  %-24s %8d matches %9.1f MiB/s\n",
+                    cs == Qt::CaseSensitive ? "QString::indexOf" : "QString::indexOf nocase", count,
+                    mibPerSec(size, timer.nsecsElapsed()));
+    }
+
+    std::printf("\n%s\n", ok ? "All backends agree" : "Backends DISAGREE");
+    return ok ? 0 : 1;
+}
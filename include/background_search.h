@@ -0,0 +1,51 @@
+#pragma once
+
+#include <QObject>
+#include <QMap>
+#include <QThreadPool>
+#include <QVector>
+#include <memory>
+#include "log_line_store.h"
+#include "log_view.h"
+
+// Finds every match of a term in a snapshot of a LogLineStore on a thread
+// pool. The store's chunks are the work units: pool threads take the next
+// chunk, scan it and post its matches back. Results are handed out in text
+// order as soon as all earlier chunks are done, so the match list fills in
+// from the top. Signals are emitted on the thread that owns this object.
+class BackgroundSearch : public QObject
+{
+    Q_OBJECT
+public:
+    explicit BackgroundSearch(QObject *parent = nullptr);
+    // Cancels and waits for the pool threads
+    ~BackgroundSearch();
+
+    // Cancels any running search. Terms containing '\n' never match.
+    void start(const LogLineStore &store, const QString &term);
+    // Results of a cancelled search are dropped, including those in flight
+    void cancel();
+
+    bool isRunning() const { return state_ != nullptr; }
+    QString term() const { return term_; }
+
+    // Shared by one search and its pool tasks
+    struct State;
+
+signals:
+    // The next matches in text order; append them to what came before
+    void matchesFound(const QVector<LogView::Position> &matches);
+    void progress(int blocksDone, int blocksTotal, int matchCount);
+    void finished(int matchCount);
+
+private:
+    void blockDone(const std::shared_ptr<State> &state, int block, const QVector<LogView::Position> &matches);
+
+    QThreadPool pool_;
+    std::shared_ptr<State> state_;
+    QString term_;
+    QMap<int, QVector<LogView::Position>> pending_;   // finished out of order
+    int nextBlock_ = 0;
+    int blocksDone_ = 0;
+    int matchCount_ = 0;
+};
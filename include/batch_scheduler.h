@@ -0,0 +1,81 @@
+#pragma once
+
+#include <QObject>
+#include <QMutex>
+#include <QVector>
+#include <QWaitCondition>
+#include <atomic>
+
+class QThread;
+class SerialWorker;
+
+// One parsed line of a batch script
+struct BatchStep
+{
+    enum Kind { Send, Delay, RandomDelay, Comment };
+
+    Kind kind = Comment;
+    QString text;           // command or comment as shown in the log
+    QByteArray payload;     // Send: encoded bytes (EOL / HEX already applied)
+    double delayMs = 0.0;   // Delay
+    quint32 minMs = 0;      // RandomDelay
+    quint32 maxMs = 0;
+};
+
+// Runs a batch script on its own thread so the GUI and RX processing keep
+// going. Every step has an absolute deadline on a monotonic clock (delays do
+// not accumulate drift), and the thread sleeps on a condition variable with a
+// precise deadline, so pause/cancel wake it immediately. A send the worker's
+// TX queue refuses is retried once the queue has drained (txQueueLow).
+// Signals are emitted from the scheduler thread.
+class BatchScheduler : public QObject
+{
+    Q_OBJECT
+public:
+    explicit BatchScheduler(QObject *parent = nullptr);
+    ~BatchScheduler();
+
+    // worker must stay alive until finished() (or cancel() has returned)
+    bool start(SerialWorker *worker, const QVector<BatchStep> &steps);
+    void pause();
+    void resume();
+    // Stops the script and waits for the thread to exit
+    void cancel();
+
+    bool isRunning() const;
+    bool isPaused() const;
+    const SerialWorker *worker() const { return worker_; }
+    // SerialWorker::monotonicNs() the schedule of the current (or last) run
+    // counts from; set before its first signal
+    qint64 startNs() const { return startNs_.load(); }
+
+signals:
+    void progress(int done, int total);
+    // A command was queued for TX; payload is the exact bytes handed to
+    // sendData(), times are SerialWorker::monotonicNs()
+    void commandSent(const QString &text, const QByteArray &payload, qint64 scheduledNs, qint64 actualNs, bool ok);
+    void message(const QString &text);
+    // Jitter summary over all sends (actual - scheduled), in microseconds
+    void finished(bool cancelled, int sent, double meanJitterUs, double maxJitterUs);
+
+private:
+    void run();
+    // Sleep until deadlineNs; false if cancelled. Time spent paused shifts
+    // deadlineNs and every later deadline.
+    bool waitUntil(qint64 &deadlineNs);
+    // Sleep until the TX queue has drained or a short poll interval is up;
+    // false if cancelled
+    bool waitForTxRoom();
+
+    QThread *thread_ = nullptr;
+    SerialWorker *worker_ = nullptr;
+    QVector<BatchStep> steps_;
+
+    mutable QMutex mutex_;
+    QWaitCondition cond_;
+    bool paused_ = false;
+    bool cancelled_ = false;
+    std::atomic<qint64> startNs_{0};
+    bool txLow_ = false;    // txQueueLow seen since the last refused send
+    QMetaObject::Connection txLowConnection_;
+};
@@ -0,0 +1,179 @@
+#pragma once
+
+#include <QByteArray>
+#include <QFile>
+#include <QHash>
+#include <QMutex>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QWaitCondition>
+#include <atomic>
+#include <deque>
+#include <vector>
+
+class QThread;
+
+// Raw serial traffic with timestamps, kept in independently compressed
+// blocks so a capture can be read from any point without inflating what
+// comes before it.
+//
+// File layout, little-endian:
+//   header   "SGCAP\0\0\1", u32 version, i64 wall-clock ms and i64
+//            monotonic ns at the start (to turn timestamps into dates)
+//   block*   "SGBK", u32 compressed size, u32 raw size, u32 records,
+//            u32 payload bytes, i64 first and last timestamp, u64 payload
+//            bytes before it, then the qCompress() output
+//   index    "SGIX", u32 count, one block header (plus its file offset)
+//            per block
+//   trailer  u64 offset of the index, "SGEND\0\0\0"
+// A raw block is a run of records: i64 timestamp (SerialWorker::
+// monotonicNs()), u8 direction, u8 port, u32 size, then the bytes. Every
+// block starts by naming the ports it uses, so any block reads on its own.
+// A capture that was not closed (crash) has no index; the reader then walks
+// the block headers instead.
+namespace Capture {
+
+enum class Direction : quint8 {
+    Rx = 0,
+    Tx = 1,
+    PortName = 2    // data is the name of port
+};
+
+struct BlockInfo {
+    qint64 fileOffset = 0;      // of the block header
+    quint32 compressedSize = 0;
+    quint32 rawSize = 0;
+    quint32 records = 0;
+    quint32 payloadSize = 0;    // RX/TX bytes in the block
+    qint64 firstTimestampNs = 0;
+    qint64 lastTimestampNs = 0;
+    quint64 firstByte = 0;      // RX/TX bytes in earlier blocks
+};
+
+struct Record {
+    qint64 timestampNs = 0;
+    Direction direction = Direction::Rx;
+    int port = 0;
+    QByteArray data;
+};
+
+} // namespace Capture
+
+// Appends traffic to a capture file. append() only copies the record into
+// the open block under a mutex; full blocks (or one second's worth) are
+// compressed and written by a writer thread, so recording keeps up with the
+// port. Thread-safe.
+class CaptureWriter
+{
+public:
+    // Raw bytes per block; the unit of compression and of seeking
+    static const int kBlockBytes = 256 * 1024;
+    // Sealed blocks waiting for the writer before new data is dropped
+    static const int kMaxQueuedBlocks = 64;
+    // A record stores its port id in one byte
+    static const int kMaxPorts = 256;
+
+    CaptureWriter() = default;
+    // Closes the file
+    ~CaptureWriter();
+
+    // level is the zlib level for qCompress(); 1 is fastest
+    bool open(const QString &path, int level = 1);
+    // Writes the remaining blocks, the index and the trailer
+    void close();
+    bool isOpen() const { return thread_ != nullptr; }
+    QString fileName() const { return path_; }
+
+    // Small id for a port name, registered on first use; -1 (and an error)
+    // beyond kMaxPorts names. append() drops data for a port of -1.
+    int portId(const QString &name);
+    void append(Capture::Direction direction, int port, qint64 timestampNs, const char *data, int size);
+
+    QString errorString() const;
+    quint64 bytesIn() const { return bytesIn_.load(std::memory_order_relaxed); }
+    quint64 bytesWritten() const { return bytesWritten_.load(std::memory_order_relaxed); }
+    quint64 bytesDropped() const { return bytesDropped_.load(std::memory_order_relaxed); }
+
+private:
+    struct Block {
+        QByteArray raw;
+        quint32 records = 0;
+        quint32 payloadSize = 0;
+        qint64 firstTimestampNs = 0;
+        qint64 lastTimestampNs = 0;
+        quint64 firstByte = 0;
+        qint64 sealAtMs = 0;    // sealed by age after this
+    };
+
+    void run();
+    // Under mutex_: start a block with the port names
+    void beginBlock();
+    void addRecord(Capture::Direction direction, int port, qint64 timestampNs, const char *data, int size);
+    void sealBlock();
+    // Writer thread
+    void writeBlock(const Block &block);
+    void writeIndex();
+
+    QString path_;
+    int level_ = 1;
+    QThread *thread_ = nullptr;
+    QFile file_;            // writer thread while open
+
+    mutable QMutex mutex_;
+    QWaitCondition wake_;
+    Block current_;
+    bool blockOpen_ = false;
+    std::deque<Block> queue_;
+    QHash<QString, int> ports_;
+    QStringList portNames_;
+    quint64 payloadBytes_ = 0;
+    bool stop_ = false;
+    QString error_;
+
+    std::vector<Capture::BlockInfo> index_;   // writer thread
+    std::atomic<quint64> bytesIn_{0};
+    std::atomic<quint64> bytesWritten_{0};
+    std::atomic<quint64> bytesDropped_{0};
+};
+
+// Random access to a capture: the block index is read (or rebuilt) on
+// open() and any block can be inflated on its own.
+class CaptureReader
+{
+public:
+    // True if the file starts with the capture magic
+    static bool isCapture(const QString &path);
+
+    bool open(const QString &path);
+    void close();
+    QString errorString() const { return error_; }
+
+    qint64 startWallClockMs() const { return startWallMs_; }
+    qint64 startMonotonicNs() const { return startMonotonicNs_; }
+
+    int blockCount() const { return int(index_.size()); }
+    const Capture::BlockInfo &block(int i) const { return index_[size_t(i)]; }
+    // Records of block i (port names included); false if it is damaged
+    bool readBlock(int i, QVector<Capture::Record> &out);
+    // Port names seen in the blocks read so far, by port id
+    QStringList portNames() const { return portNames_; }
+
+    // Block holding timestampNs (or the first one after it) / holding the
+    // given payload byte; blockCount() if there is none
+    int blockForTime(qint64 timestampNs) const;
+    int blockForByte(quint64 offset) const;
+    // RX/TX bytes in the whole capture
+    quint64 payloadBytes() const;
+
+private:
+    bool readIndex();
+    void scanBlocks();
+
+    QFile file_;
+    QString error_;
+    qint64 startWallMs_ = 0;
+    qint64 startMonotonicNs_ = 0;
+    std::vector<Capture::BlockInfo> index_;
+    QStringList portNames_;
+};
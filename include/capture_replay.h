@@ -0,0 +1,83 @@
+#pragma once
+
+#include "capture_file.h"
+#include "rx_buffer_pool.h"
+#include <QObject>
+
+class QTimer;
+
+// Plays a capture back as if its ports were open. RX records are copied into
+// pooled RxChunks and emitted like SerialWorker::dataReceived, so framing,
+// log, highlighter and plotter see the same input as they did live. Records
+// are due at their recorded offset from the first one divided by the speed;
+// at speed 0 they are emitted as fast as the GUI thread takes them, and the
+// byte rate it reaches is the rate the pipeline can sustain. Blocks are
+// inflated one at a time as the replay reaches them, and a replay that
+// starts part way in finds its first block through the capture's index.
+class CaptureReplay : public QObject
+{
+    Q_OBJECT
+public:
+    // Longest stretch spent emitting before the event loop gets a turn
+    static const int kSliceMs = 20;
+    // Check for due records this often when paced
+    static const int kTickMs = 5;
+
+    // What the start offset of a replay counts
+    enum class SeekBy {
+        Time,   // ns after the first record
+        Byte    // RX/TX payload bytes
+    };
+
+    explicit CaptureReplay(QObject *parent = nullptr);
+
+    // speed is a multiple of real time; 0 = as fast as possible. The replay
+    // begins with the record at (or holding) offset; false if the capture
+    // ends before it.
+    bool start(const QString &path, double speed, SeekBy by = SeekBy::Time, qint64 offset = 0);
+    void stop();
+    bool isRunning() const;
+    double speed() const { return speed_; }
+    QString fileName() const { return path_; }
+    QString errorString() const { return error_; }
+
+    // RX/TX bytes emitted so far and from the start point to the end
+    quint64 bytesReplayed() const { return bytes_; }
+    quint64 bytesTotal() const { return total_; }
+    // Since start(), and the part of it spent reading and inflating blocks
+    qint64 elapsedNs() const;
+    qint64 decodeNs() const { return decodeNs_; }
+    // Bytes per second through the pipeline, block decoding left out
+    double pipelineRate() const;
+    // Blocks skipped because they could not be read
+    int damagedBlocks() const { return damaged_; }
+
+signals:
+    // Chunk timestamps are on the SerialWorker::monotonicNs() clock of the replay
+    void dataReceived(const QString &port, const RxChunk &chunk);
+    void dataSent(const QString &port, const QByteArray &data);
+    void finished(bool stopped);
+
+private:
+    void tick();
+    // Next block into records_; false at the end
+    bool loadNextBlock();
+    void emitRecord(const Capture::Record &record, qint64 atNs);
+    void finish(bool stopped);
+
+    QTimer *timer_;
+    CaptureReader reader_;
+    QString path_;
+    QString error_;
+    double speed_ = 1.0;
+    int nextBlock_ = 0;
+    QVector<Capture::Record> records_;
+    int nextRecord_ = 0;
+    qint64 firstTimestampNs_ = 0;
+    qint64 startNs_ = 0;
+    qint64 endNs_ = 0;
+    qint64 decodeNs_ = 0;
+    quint64 bytes_ = 0;
+    quint64 total_ = 0;
+    int damaged_ = 0;
+};
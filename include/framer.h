@@ -0,0 +1,51 @@
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+#include <functional>
+
+// One complete frame. data points either into the chunk passed to feed() or
+// into the framer's own carry buffer, and is only valid during the callback.
+struct FrameView
+{
+    const char *data = nullptr;
+    int size = 0;
+    // Terminating byte for delimiter framers (included in data), -1 for
+    // framers that strip their framing (SLIP, COBS, length-prefixed) and for
+    // frames cut at the size limit.
+    int delimiter = -1;
+};
+
+// Splits a byte stream into frames. feed() looks at every input byte once
+// (memchr for delimiters) and walks the chunk with a read offset; only an
+// incomplete frame at the end is copied to wait for the next chunk.
+class Framer
+{
+public:
+    enum class Kind {
+        LineOrEtx,        // 0x0A or 0xDD (ETX), the historical default
+        Lf,
+        CrLf,
+        Etx,
+        Slip,             // RFC 1055
+        Cobs,             // 0x00-delimited consistent overhead byte stuffing
+        LengthPrefixed    // 16-bit big-endian length, then payload
+    };
+    using FrameHandler = std::function<void(const FrameView &frame)>;
+
+    // Partial frames longer than this are passed on as they are
+    static const int kMaxFrameSize = 1024 * 1024;
+
+    virtual ~Framer() = default;
+
+    virtual void feed(const char *data, int size, const FrameHandler &onFrame) = 0;
+    // Drop any partially received frame
+    virtual void reset() = 0;
+    // Bytes of the next frame received so far
+    virtual int pendingSize() const = 0;
+
+    static Framer *create(Kind kind);
+    // Names used in settings.txt and for display
+    static QString kindName(Kind kind);
+    static Kind kindFromName(const QString &name);
+};
@@ -7,6 +7,7 @@
 class QLineEdit;
 class QPushButton;
 class QCheckBox;
+class QVBoxLayout;
 
 class HighlightRulesDialog : public QDialog
 {
@@ -25,11 +26,22 @@ private slots:
     void accept() override;
 
 private:
-    static const int kMaxRules = 5; // show 5 quick slots
-    QLineEdit *patternEdits[kMaxRules];
-    QPushButton *colorButtons[kMaxRules];
-    QCheckBox *enableChecks[kMaxRules];
-
+    static const int kMaxRules = 500;
+    static const int kMinRows = 5;   // empty slots shown for a fresh setup
+
+    struct RuleRow {
+        QWidget *row;
+        QLineEdit *patternEdit;
+        QPushButton *colorButton;
+        QCheckBox *enableCheck;
+        QColor color;
+    };
+    QVector<RuleRow> rows_;
+    QVBoxLayout *rowsLayout_;
+    QPushButton *addBtn_;
+
+    void addRow(const HighlightRule &rule);
+    void removeRow(QWidget *row);
     void loadFromSettings();
     void saveToSettings(const QVector<HighlightRule> &r);
 };
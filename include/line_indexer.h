@@ -0,0 +1,42 @@
+#pragma once
+
+#include <QObject>
+#include <QThreadPool>
+#include <memory>
+#include <vector>
+
+// Builds the line index of a mapped file on a pool thread. The text is cut
+// into pieces of about LogLineStore::kChunkSize that end after a '\n', and
+// the line starts of each piece are posted back in order, so a viewer can
+// show the top of the file while the rest is still being scanned. Signals
+// are emitted on the thread that owns this object.
+class LineIndexer : public QObject
+{
+    Q_OBJECT
+public:
+    explicit LineIndexer(QObject *parent = nullptr);
+    // Cancels and waits for the pool thread
+    ~LineIndexer();
+
+    // Cancels any running scan. owner keeps data valid while it is read.
+    void start(std::shared_ptr<const void> owner, const char *data, qint64 size);
+    // Pieces of a cancelled scan are dropped, including those in flight;
+    // cancelled() is emitted instead of finished() if a scan was running
+    void cancel();
+    bool isRunning() const { return state_ != nullptr; }
+
+    // Shared by one scan and its pool task
+    struct State;
+
+signals:
+    // The next size bytes, with the offsets of the lines starting in them
+    void pieceIndexed(int size, const std::vector<quint32> &starts);
+    void finished();
+    void cancelled();
+
+private:
+    void pieceDone(const std::shared_ptr<State> &state, int size, const std::vector<quint32> &starts, bool last);
+
+    QThreadPool pool_;
+    std::shared_ptr<State> state_;
+};
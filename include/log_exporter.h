@@ -0,0 +1,48 @@
+#pragma once
+
+#include <QObject>
+#include <QString>
+#include <QThreadPool>
+#include <memory>
+
+class LogLineStore;
+
+// Saves the text of a LogLineStore to a file on a pool thread. start() takes
+// a snapshot, so logging carries on while the file is written; each chunk is
+// written as is (spilled ones are read back one at a time) and let go once
+// written, so the export needs no more than a chunk of memory of its own.
+// The file is written through QSaveFile: a cancelled or failed export leaves
+// an existing file untouched. Signals are emitted on the thread that owns
+// this object.
+class LogExporter : public QObject
+{
+    Q_OBJECT
+public:
+    explicit LogExporter(QObject *parent = nullptr);
+    // Cancels and waits for the pool thread
+    ~LogExporter();
+
+    // Fails if an export is running
+    bool start(const LogLineStore &store, const QString &path);
+    // The file is left as it was; finished() follows
+    void cancel();
+    // Let a running export finish, e.g. before quitting
+    void waitForDone();
+    bool isRunning() const { return state_ != nullptr; }
+    QString fileName() const { return path_; }
+
+    // Shared by one export and its pool task
+    struct State;
+
+signals:
+    void progress(qint64 bytesDone, qint64 bytesTotal);
+    // error is empty unless the file could not be written
+    void finished(bool cancelled, const QString &error);
+
+private:
+    void taskDone(const std::shared_ptr<State> &state, const QString &error);
+
+    QThreadPool pool_;
+    std::shared_ptr<State> state_;
+    QString path_;
+};
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <QByteArray>
+#include <QDateTime>
+#include <QMutex>
+#include <QString>
+#include <QWaitCondition>
+#include <atomic>
+
+class QFile;
+class QThread;
+
+// Streams log text to files in a directory as it arrives. append() only
+// copies into a buffer; a writer thread swaps the buffer out every batch
+// interval (or as soon as a batch fills) and writes it with one call, so the
+// GUI never waits on the disk. Files are named stream_yyMMdd_hhmmss.txt and
+// a new one is started when the current one reaches a size or an age; each
+// new file deletes the oldest stream_*.txt in the directory beyond the
+// retention limits. Other files there, such as the log_*.txt saved on Clear
+// or by hand, are left alone.
+class LogFileWriter
+{
+public:
+    // When written data is forced to the device with fsync
+    enum class SyncPolicy {
+        Never,        // leave it to the OS
+        EveryBatch,   // after every write
+        Interval      // at most once per syncIntervalMs
+    };
+
+    struct Settings {
+        QString dir;
+        qint64 maxFileBytes = 64 * 1024 * 1024;   // 0 = no size limit
+        int maxFileMinutes = 60;                  // 0 = no age limit
+        int keepFiles = 0;                        // 0 = no file count limit
+        qint64 keepBytes = 0;                     // all files together; 0 = no limit
+        SyncPolicy sync = SyncPolicy::Interval;
+        int syncIntervalMs = 1000;
+        int batchIntervalMs = 200;
+    };
+
+    // Written at once when this much is buffered
+    static const int kBatchBytes = 1024 * 1024;
+    // Beyond this much buffered (the disk is not keeping up) data is dropped
+    static const int kMaxBufferBytes = 64 * 1024 * 1024;
+
+    LogFileWriter() = default;
+    // Writes what is buffered
+    ~LogFileWriter();
+
+    bool start(const Settings &settings);
+    // Writes what is buffered, syncs and closes the file
+    void stop();
+    bool isRunning() const { return thread_ != nullptr; }
+    Settings settings() const { return settings_; }
+
+    // Thread-safe, never blocks on I/O
+    void append(const char *data, int size);
+    void append(const QByteArray &data) { append(data.constData(), data.size()); }
+    // Close the current file after what is buffered; the next text starts a new one
+    void rotate();
+
+    QString currentFile() const;
+    // Last open/write error, empty if none
+    QString errorString() const;
+    quint64 bytesWritten() const { return written_.load(std::memory_order_relaxed); }
+    quint64 bytesDropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+    void run();
+    // Writer thread: write one batch, opening or rotating files as needed
+    void writeBatch(const QByteArray &batch, bool rotateAfter);
+    bool openNewFile();
+    // Delete the oldest files beyond keepFiles / keepBytes; never the current one
+    void pruneOldFiles();
+    void closeFile();
+    void sync();
+
+    Settings settings_;
+    QThread *thread_ = nullptr;
+
+    mutable QMutex mutex_;
+    QWaitCondition wake_;
+    QByteArray buffer_;
+    bool stop_ = false;
+    bool rotate_ = false;
+    QString currentFile_;
+    QString error_;
+
+    // Writer thread only
+    QFile *file_ = nullptr;
+    qint64 fileBytes_ = 0;
+    QDateTime fileOpened_;
+    qint64 lastSyncMs_ = 0;
+    bool unsynced_ = false;
+
+    std::atomic<quint64> written_{0};
+    std::atomic<quint64> dropped_{0};
+};
@@ -1,9 +1,10 @@
 #pragma once
 
-#include <QSyntaxHighlighter>
-#include <QTextCharFormat>
+#include <QObject>
+#include <QTextLayout>
 #include <QVector>
 #include <QColor>
+#include <vector>
 
 struct HighlightRule {
     QString pattern;
@@ -11,11 +12,16 @@ struct HighlightRule {
     bool enabled = true;
 };
 
-class LogHighlighter : public QSyntaxHighlighter
+// Rule-based highlighting for LogView. The view asks for the formats of each
+// line it paints, so only visible lines are ever highlighted.
+//
+// The enabled rules are compiled into one case-insensitive Aho-Corasick
+// automaton, so a line is scanned once however many rules there are.
+class LogHighlighter : public QObject
 {
     Q_OBJECT
 public:
-    explicit LogHighlighter(QTextDocument *parent = nullptr);
+    explicit LogHighlighter(QObject *parent = nullptr);
 
     void setRules(const QVector<HighlightRule> &rules);
     QVector<HighlightRule> rules() const { return rules_; }
@@ -24,9 +30,29 @@ public:
     void loadFromSettings();
     void saveToSettings() const;
 
-protected:
-    void highlightBlock(const QString &text) override;
+    // Append the formats for one line of log text
+    void highlightLine(const QString &text, QVector<QTextLayout::FormatRange> &formats) const;
+    // Changes with every rule change; formats cached under another value are stale
+    quint64 generation() const { return generation_; }
+
+signals:
+    void rulesChanged();
 
 private:
+    // Trie node; edges sorted by (case-folded) UTF-16 code unit
+    struct Node {
+        std::vector<std::pair<ushort, int>> next;
+        int fail = 0;           // longest proper suffix that is a trie node
+        int output = 0;         // nearest node on the fail chain that ends a pattern, 0 = none
+        QVector<int> rules;     // rules whose pattern ends here
+    };
+
+    void compile();
+    int step(int state, ushort c) const;
+
     QVector<HighlightRule> rules_;
+    std::vector<Node> nodes_;
+    QVector<QTextCharFormat> formats_;   // per rule, built once
+    QVector<int> lengths_;               // pattern length per rule
+    quint64 generation_ = 0;
 };
@@ -0,0 +1,183 @@
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+#include <algorithm>
+#include <deque>
+#include <memory>
+#include <vector>
+
+class QFile;
+class QIODevice;
+class QTemporaryFile;
+
+// Append-only log text kept as UTF-8 in large chunks plus a per-chunk index
+// of line start offsets. Costs the UTF-8 bytes plus 4 bytes per line, and a
+// line lookup is a binary search over chunks. Lines never straddle chunks:
+// an unfinished last line moves to a new chunk when the current one fills.
+//
+// Like QTextDocument there is always at least one line: the empty store has
+// one empty line, and text ending in '\n' is followed by an empty line.
+//
+// With a scrollback limit set, the oldest complete chunks are written to a
+// spill file once the chunks in memory exceed it. Spilled chunks keep only
+// their first line number in memory; they are read back (and their line
+// index rebuilt) into a small cache when a line, search or export needs them.
+//
+// A file can also be mapped into memory and shown in place: its chunks point
+// into the mapping, so only the line index costs memory. The index is added
+// chunk by chunk with appendMapped(), usually as a background scan finds it.
+class LogLineStore
+{
+public:
+    static const int kChunkSize = 1024 * 1024;
+    // Spilled chunks held in memory at a time after being read back
+    static const int kCachedChunks = 4;
+
+    struct LineRef {
+        const char *data = nullptr;
+        int size = 0;           // without the '\n'
+    };
+
+    LogLineStore();
+    ~LogLineStore();
+
+    void append(const char *utf8, int len);
+    void append(const QByteArray &utf8) { append(utf8.constData(), utf8.size()); }
+    void append(const QString &text) { append(text.toUtf8()); }
+    // Unmaps a mapped file as well
+    void clear();
+
+    // Clear and map the file at path. Nothing shows until appendMapped().
+    // The file must not shrink while mapped.
+    bool mapFile(const QString &path, QString *error = nullptr);
+    const char *mappedData() const { return mapped_; }
+    qint64 mappedSize() const { return mappedSize_; }
+    // Bytes of the mapped file added so far
+    qint64 mappedBytes() const { return mappedBytes_; }
+    // Keeps the mapping alive for other threads, e.g. while indexing it
+    std::shared_ptr<const void> mapping() const { return mappedFile_; }
+    // Add the next size bytes of the mapped file as one chunk. starts are
+    // the line start offsets within it; the bytes must end after a '\n'
+    // unless they are the last of the file. Call before any append().
+    void appendMapped(int size, std::vector<quint32> starts);
+
+    // Bytes of text to keep in memory before spilling to disk; 0 = no limit.
+    // The spill file is created in dir when first needed.
+    void setScrollbackLimit(qint64 bytes, const QString &dir);
+    qint64 scrollbackLimit() const { return limit_; }
+    // Set if the spill file could not be written; everything stays in memory
+    QString spillError() const { return spillError_; }
+
+    bool isEmpty() const { return bytes_ == 0; }
+    quint64 lineCount() const { return lines_ + (openLine() ? 0 : 1); }
+    quint64 byteCount() const { return bytes_; }
+    // True if the last line has no '\n' yet (and the store is not empty)
+    bool openLine() const { return bytes_ > 0 && lastByte_ != '\n'; }
+    // Bytes held in memory, including index and slack
+    qint64 memoryUsage() const;
+    // Bytes of text moved to the spill file
+    qint64 spilledBytes() const { return spillSize_; }
+    // Longest line seen so far, in bytes
+    int maxLineLength() const { return maxLineLength_; }
+
+    // Valid until the next call into the store, which may drop a spilled
+    // chunk from the cache
+    LineRef line(quint64 index) const;
+    QString lineText(quint64 index) const;
+
+    // Locate the first occurrence of needle at or after (line, byteColumn),
+    // or the last one that starts before it. Matches never span lines.
+    // Returns false if there is none.
+    bool findNext(const QByteArray &needle, quint64 &line, int &byteColumn) const;
+    bool findPrevious(const QByteArray &needle, quint64 &line, int &byteColumn) const;
+    // Call fn(line, byteColumn) for every occurrence, in order, optionally
+    // only for those starting at or after (line, byteColumn)
+    template <typename Fn>
+    void forEachMatch(const QByteArray &needle, Fn fn) const { forEachMatch(needle, 0, 0, fn); }
+    template <typename Fn>
+    void forEachMatch(const QByteArray &needle, quint64 line, int byteColumn, Fn fn) const;
+
+    // Read-only view of the text for other threads. Chunks in memory are
+    // shared with the store (copy-on-write), mapped ones stay valid while
+    // the snapshot holds the mapping, and spilled ones are read from
+    // spillPath, which stays valid until clear().
+    struct Snapshot {
+        struct Block {
+            QByteArray data;            // empty if spilled
+            quint64 firstLine = 0;
+            qint64 spillOffset = -1;
+            int spillSize = 0;
+        };
+        std::vector<Block> blocks;
+        QString spillPath;
+        std::shared_ptr<const void> mapping;
+    };
+    Snapshot snapshot() const;
+
+    // Stream the whole text out chunk by chunk
+    bool writeTo(QIODevice *out) const;
+
+private:
+    struct Chunk {
+        QByteArray data;
+        std::vector<quint32> starts;   // line start offsets within data
+        quint64 firstLine = 0;         // global index of starts[0]
+        qint64 spillOffset = -1;       // position in the spill file, -1 if never spilled
+        int spillSize = 0;
+    };
+
+    int chunkForLine(quint64 index) const;
+    int chunkLineEnd(const Chunk &c, size_t local) const;
+    Chunk &newChunk();
+    // Chunk ci with its data and line index in memory
+    const Chunk &loaded(int ci) const;
+    // Text of chunk ci, read from the spill file if needed but not cached
+    QByteArray chunkData(int ci) const;
+    void enforceLimit();
+    bool spill(Chunk &c);
+    // Byte offset within chunk c -> line index (global)
+    quint64 lineAt(const Chunk &c, int offset) const;
+    const char *search(const char *begin, const char *end, const QByteArray &needle) const;
+
+    // Spilled chunks are read back on demand from const lookups
+    mutable std::vector<Chunk> chunks_;
+    mutable std::deque<int> cache_;    // spilled chunks currently read back
+    size_t firstResident_ = 0;         // chunks before this one are spilled
+    qint64 residentBytes_ = 0;         // text bytes in chunks from firstResident_ on
+    qint64 limit_ = 0;
+    QString spillDir_;
+    std::unique_ptr<QTemporaryFile> spillFile_;
+    qint64 spillSize_ = 0;
+    QString spillError_;
+    std::shared_ptr<QFile> mappedFile_;
+    const char *mapped_ = nullptr;
+    qint64 mappedSize_ = 0;
+    qint64 mappedBytes_ = 0;
+    quint64 lines_ = 0;       // line starts stored in chunks_
+    quint64 bytes_ = 0;
+    char lastByte_ = 0;
+    int maxLineLength_ = 0;
+};
+
+template <typename Fn>
+void LogLineStore::forEachMatch(const QByteArray &needle, quint64 line, int byteColumn, Fn fn) const
+{
+    if (needle.isEmpty() || line >= lines_)
+        return;
+    const int first = chunkForLine(line);
+    for (int ci = first; ci < int(chunks_.size()); ++ci) {
+        const Chunk &c = loaded(ci);
+        const char *begin = c.data.constData();
+        const char *end = begin + c.data.size();
+        const char *p = begin;
+        if (ci == first)
+            p = std::min(end, begin + c.starts[size_t(line - c.firstLine)] + byteColumn);
+        while ((p = search(p, end, needle)) != end) {
+            const int off = int(p - begin);
+            const quint64 index = lineAt(c, off);
+            fn(index, off - int(c.starts[size_t(index - c.firstLine)]));
+            p += needle.size();
+        }
+    }
+}
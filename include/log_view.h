@@ -0,0 +1,150 @@
+#pragma once
+
+#include <QAbstractScrollArea>
+#include <QColor>
+#include <QHash>
+#include <QTextLayout>
+#include <QVector>
+#include <deque>
+#include <vector>
+#include "log_line_store.h"
+
+class LogHighlighter;
+class LineIndexer;
+
+// Read-only log viewer over a LogLineStore. Lines are not wrapped and only
+// the rows inside the viewport are laid out and painted, so scrolling and
+// appending cost the same with ten lines or ten million.
+class LogView : public QAbstractScrollArea
+{
+    Q_OBJECT
+public:
+    // A place in the text: line index and UTF-16 column within that line
+    struct Position {
+        quint64 line = 0;
+        int column = 0;
+        bool operator==(const Position &o) const { return line == o.line && column == o.column; }
+        bool operator!=(const Position &o) const { return !(*this == o); }
+        bool operator<(const Position &o) const { return line != o.line ? line < o.line : column < o.column; }
+    };
+
+    // Lines longer than this are cut off on screen (copying still gets all)
+    static const int kMaxDisplayColumns = 8192;
+    // Rows above and below the viewport whose search matches and
+    // highlight formats are kept
+    static const int kSearchMargin = 64;
+
+    explicit LogView(QWidget *parent = nullptr);
+
+    const LogLineStore &store() const { return store_; }
+    // Position just past the last character
+    Position endPosition() const;
+    void appendText(const QString &text);
+    void appendUtf8(const char *data, int len);
+    void clear();
+    // Show a file in place instead of reading it in: it is mapped and its
+    // lines are indexed in the background, so the first screen appears as
+    // soon as the first chunk is done. Do not append until loadFinished().
+    // Returns false, with the view cleared, if the file cannot be mapped.
+    bool openMapped(const QString &path, QString *error = nullptr);
+    bool isLoading() const;
+    // Keep about this many bytes of text in memory; older lines spill to a
+    // file in dir and stay scrollable and searchable. 0 = no limit.
+    void setScrollbackLimit(qint64 bytes, const QString &dir) { store_.setScrollbackLimit(bytes, dir); }
+
+    // Keep the last line in view as text arrives
+    void setAutoScroll(bool on) { autoScroll_ = on; }
+    void setHighlighter(LogHighlighter *highlighter);
+    // Mark occurrences of term. Only the rows around the viewport are
+    // searched, and only again when scrolling leaves them.
+    void setSearchHighlight(const QString &term, const QColor &background, const QColor &foreground);
+    // Hide complete lines that start with any of these prefixes
+    void setHiddenPrefixes(const QVector<QByteArray> &prefixes);
+
+    bool hasSelection() const { return anchor_ != cursor_; }
+    Position selectionStart() const { return qMin(anchor_, cursor_); }
+    Position selectionEnd() const { return qMax(anchor_, cursor_); }
+    void setSelection(const Position &anchor, const Position &cursor);
+    QString selectedText() const;
+    void selectAll();
+    void copy() const;
+    void moveCursorToStart();
+    void moveCursorToEnd();
+    void ensureVisible(const Position &pos);
+
+    // Case-sensitive search starting at the cursor, like QPlainTextEdit::find.
+    // A match is selected and scrolled into view.
+    bool find(const QString &term, bool backward = false);
+    // All matches that end after the given position. Passing the old end of
+    // the text finds just the matches completed by an append.
+    QVector<Position> findAll(const QString &term, const Position &after = Position()) const;
+
+    // Convert between UTF-8 byte offsets and UTF-16 columns within a line
+    int byteToColumn(quint64 line, int byteColumn) const;
+    int columnToByte(quint64 line, int column) const;
+
+signals:
+    void loadProgress(qint64 bytesDone, qint64 bytesTotal);
+    void loadFinished();
+    // The load was cut short by clear() or another openMapped(); no
+    // loadFinished() follows
+    void loadCancelled();
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+    void changeEvent(QEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override;
+    void mouseMoveEvent(QMouseEvent *event) override;
+    void mouseReleaseEvent(QMouseEvent *event) override;
+    void mouseDoubleClickEvent(QMouseEvent *event) override;
+    void keyPressEvent(QKeyEvent *event) override;
+    void contextMenuEvent(QContextMenuEvent *event) override;
+
+private:
+    void afterAppend(quint64 oldLastRow);
+    void updateMetrics();
+    void updateScrollBars();
+    int pageRows() const;
+    // Rows are what is shown: all lines, or only those passing the filter
+    quint64 rowCount() const;
+    quint64 lineForRow(quint64 row) const;
+    quint64 rowForLine(quint64 line) const;
+    bool lineHidden(quint64 line) const;
+    void extendFilterIndex();
+    QString displayText(quint64 line) const;
+    void layoutLine(QTextLayout &layout, quint64 line, const QString &text,
+                    const QVector<int> *matches = nullptr) const;
+    // Highlighter formats of a line, cached until the rules change
+    QVector<QTextLayout::FormatRange> ruleFormats(quint64 line, const QString &text) const;
+    // Forget cached formats of lines outside the given rows plus the margin
+    void pruneRuleFormats(quint64 firstRow, quint64 rows);
+    // Make searchRows_ cover the given rows plus the margin
+    void updateSearchWindow(quint64 firstRow, quint64 rows);
+    void resetSearchWindow();
+    Position positionAt(const QPoint &pt) const;
+
+    LogLineStore store_;
+    LineIndexer *indexer_;
+    LogHighlighter *highlighter_ = nullptr;
+    // Formats of complete lines near the viewport, valid for one rule generation
+    mutable QHash<quint64, QVector<QTextLayout::FormatRange>> ruleFormats_;
+    mutable quint64 ruleFormatsGeneration_ = 0;
+    bool autoScroll_ = true;
+    int lineHeight_ = 1;
+    int charWidth_ = 1;
+
+    QString searchTerm_;
+    QColor searchBackground_;
+    QColor searchForeground_;
+    quint64 searchFirstRow_ = 0;
+    std::deque<QVector<int>> searchRows_;   // match columns of rows from searchFirstRow_
+
+    QVector<QByteArray> hiddenPrefixes_;
+    std::vector<quint64> visibleLines_;   // complete lines passing the filter
+    quint64 filteredUpTo_ = 0;            // complete lines checked so far
+
+    Position anchor_;
+    Position cursor_;
+    bool selecting_ = false;
+};
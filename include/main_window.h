@@ -5,16 +5,43 @@
 #include <QLineEdit>
 #include <QStringList>
 #include "serial_worker.h"
+#include "batch_scheduler.h"
+#include "framer.h"
+#include "traffic_generator.h"
+#include "log_view.h"
+#include "background_search.h"
+#include "vocabulary_index.h"
+#include "log_file_writer.h"
+#include "capture_file.h"
+#include "capture_replay.h"
+#include "log_exporter.h"
 #include "plot_widget.h"
 #include <QColor>
+#include <memory>
 
 class QTextEdit;
 class QPlainTextEdit;
 class QCompleter;
+class QStringListModel;
 class QTimer;
 class QPushButton;
 class QComboBox;
 class QDialog;
+class QListWidget;
+class QListWidgetItem;
+class QProgressBar;
+
+// One open serial port: its own worker (I/O thread + RX ring) and framer state
+struct PortSession
+{
+    QString name;
+    SerialWorker *worker = nullptr;
+    std::unique_ptr<Framer> framer; // Splits RX chunks into lines / packets
+    bool shown = true;              // Per-port log filter
+    QListWidgetItem *item = nullptr;
+    quint64 lastRxBytes = 0;        // For the per-port rate in the session list
+    int loggedPartial = 0;          // Start of the framer's partial frame, logged raw already
+};
 
 // Custom QLineEdit with arrow key support for command history
 class CommandLineEdit : public QLineEdit
@@ -39,6 +66,10 @@ public:
     explicit MainWindow(QWidget *parent = nullptr);
     ~MainWindow();
 
+protected:
+    // Exit and closing the window both end here
+    void closeEvent(QCloseEvent *event) override;
+
 signals:
     void newSerialData(const QMap<QString, double> &values);
     void clearData(void);
@@ -47,7 +78,6 @@ private slots:
     void openSerial();
     void closeSerial();
     void sendCommand();
-    void onDataReceived(const QByteArray &data);
     void onError(const QString &msg);
     void searchLog();
     void searchUp();
@@ -63,13 +93,40 @@ private slots:
 
     private:
     void updatePortList();
+    // Log text is gathered and committed to the view once per frame
     void log(const QString &msg);
-    void onDataPlotter(const QString &line);
+    void logUtf8(const char *data, int size);
+    void flushLog();
+    void onSessionData(PortSession *session, const RxChunk &chunk);
+    void onDataPlotter(const char *line, int size, const QString &keyPrefix = QString());
+    PortSession *openPortSession(const QString &port, int baud);
+    void closeSession(PortSession *session);
+    PortSession *findSession(const QString &name) const;
+    void setActiveSession(PortSession *session);
+    void flushTimeline(bool all);
+    // A second port is about to be added: hand the first one over to the timeline
+    void startMergedLog(const QString &addedPort);
+    // The log view is read only: notes go in as marker lines, through the
+    // same path as received data, so they reach the store and the log file
+    void addNote();
+    // Whether the last logged line still waits for its '\n'
+    bool logLineOpen() const;
+    void applyLogFilter();
     void clearLog();
+    // Without LogToDisk the log is written to log/ before it is cleared
+    void saveClearedLog();
     void updateCompleter();
     void highlightSearchResults(const QString &term);
     void updateSearchMatches(const QString &term);
     void updateSearchCountLabel();
+    // Select match index of searchMatches_ and scroll to it
+    void goToSearchMatch(int index);
+    // Direct search from the cursor, for when the match list does not reach it yet
+    bool findFromCursor(const QString &term, bool backward);
+    void onBackgroundSearchFinished();
+    void onLogLoadProgress(qint64 bytesDone, qint64 bytesTotal);
+    void onLogLoaded();
+    void onLogLoadCancelled();
     void timerHandler();
     void showMessageAutoClose(const QString &title, const QString &msg, int timeoutMs = 1500);
     void setupUi();
@@ -77,23 +134,71 @@ private slots:
     void saveCommandsToFile(const QString &content);
     void updateCommandCompleter();
     void addCommandToHistory(const QString &command);
+    // Apply the EOL mode and HEX parsing used for everything sent to the port
+    QByteArray encodeCommand(const QString &cmd, bool hex) const;
+    // Record bytes sent through worker in the capture, if one is open
+    void captureTx(const SerialWorker *worker, qint64 timestampNs, const QByteArray &bytes);
+    // Show a .sgcap capture in the log and the plotter. Blocks are decoded
+    // a slice at a time on a zero timer, as CaptureReplay does at full
+    // speed, so the window keeps painting while a big capture loads.
+    void openCapture(const QString &path);
+    void loadCaptureSlice();
+    void stopCaptureLoad();
+    struct CaptureLoad;
+    std::shared_ptr<CaptureLoad> captureLoad_;
+    QTimer *captureLoadTimer_ = nullptr;
+    void onBatchFinished(bool cancelled, int sent, double meanJitterUs, double maxJitterUs);
+    void onExportFinished(bool cancelled, const QString &error);
 
     // Track search state for Enter behavior in searchLine_
     QString lastSearchTerm_;
     bool searchReturnActive_ = false;
     int currentSearchIndex_ = -1;  // Current match index (0-based)
-    QVector<int> searchMatches_;   // Positions of all matches
+    QVector<LogView::Position> searchMatches_;   // Positions of all matches, in order
+    QString searchMatchesTerm_;                  // Term searchMatches_ was built for
+    BackgroundSearch *search_;                   // Fills searchMatches_ off the GUI thread
+    LogView::Position searchEnd_;                // End of the text search_ was started on
+    bool searchNotFoundPending_ = false;         // Report "not found" when search_ finishes
 
     bool initFlag_;
-    SerialWorker *worker_;
-    QPlainTextEdit *logView_;
+    // Open ports. worker_ is the active session's worker (TX target).
+    QVector<PortSession *> sessions_;
+    PortSession *activeSession_ = nullptr;
+    SerialWorker *worker_ = nullptr;
+    QListWidget *sessionList_;
+    // With several ports open, complete lines from all of them are held for a
+    // short reorder window and then logged in receive-time order, tagged
+    // "[port] " so the log can be filtered per port.
+    struct TimelineLine {
+        qint64 timestampNs;
+        quint64 seq;
+        PortSession *session;
+        QString text;
+    };
+    QVector<TimelineLine> timeline_;
+    quint64 timelineSeq_ = 0;
+    QTimer *mergeTimer_ = nullptr;
+    // Text waiting for the next log commit, and counters for the stats line
+    QByteArray pendingLog_;
+    QTimer *logFlushTimer_ = nullptr;
+    quint64 logAppends_ = 0;
+    quint64 logCommits_ = 0;
+    quint64 lastLogAppends_ = 0;
+    quint64 lastLogCommits_ = 0;
+    LogView *logView_;
     QComboBox *portCombo_;
     QComboBox *baudCombo_;
     CommandLineEdit *commandLine_;
     QLineEdit *searchLine_;
     QLabel *searchCountLabel_;     // Label to show "x/y" search count
+    QLabel *rxStatsLabel_ = nullptr; // Status bar: RX ring fill / overflow
+    // File > Save writes a snapshot of the log in the background
+    LogExporter *exporter_ = nullptr;
+    QProgressBar *exportProgress_ = nullptr;
+    QPushButton *exportCancelBtn_ = nullptr;
     QPushButton *loadBtn_;
     QPushButton *spaceBtn_;
+    QPushButton *noteBtn_;
     QPushButton *openBtn_;
     QPushButton *closeBtn_;
     QPushButton *sendBtn_;
@@ -130,17 +235,27 @@ private slots:
     // Batch command area: multi-line edit and Send All button placed under Group 2
     QPlainTextEdit *cmdListView_;
     QPushButton *sendAllBtn_;
+    QPushButton *batchPauseBtn_;
+    QPushButton *batchCancelBtn_;
+    QProgressBar *batchProgress_;
+    // Runs "Send All" off the GUI thread with absolute-deadline timing
+    BatchScheduler *batch_;
+    bool batchHex_ = false;          // HEX mode the running script was encoded with
 
     // Basic UI elements for serial port configuration and control
     QPushButton *searchUpBtn_;
     QPushButton *searchDownBtn_;
     QPushButton *clearBtn_;
     QCheckBox *hexCheck_;
+    QCheckBox *rtsCtsCheck_;
     QCheckBox *sendHex_;
     QCheckBox *autoScrollCheck_;
-    QCheckBox *logReadOnlyCheck_;
-    QByteArray buffer_;
     QCompleter *completer_;
+    QStringListModel *completionModel_;   // completer_'s suggestions, from vocabulary_
+    VocabularyIndex vocabulary_;           // Words of the log, fed by flushLog()
+    static const int kCompletions = 20;    // Suggestions shown for the search line
+    static constexpr qint64 kMappedVocabularyBytes = 32 * 1024 * 1024;
+    qint64 vocabularyFed_ = 0;             // Bytes of a mapped file given to vocabulary_
     QCompleter *commandCompleter_;
     QTimer *timer_;
 
@@ -149,17 +264,73 @@ private slots:
     // Settings
     int logFontSize_ = 22;
     QString eolMode_ = "\n";  // "\n" for LF, "\r\n" for CR+LF
-    bool autoSaveOnExit_ = false;  // Auto-save log when exiting app
     bool autoScrollEnabled_ = true;  // Auto-scroll to end of log
     // Colors for log view and search highlight
     QColor logBgColor_ = Qt::white;
     QColor logTextColor_ = Qt::black;
     QColor searchHighlightColor_ = Qt::yellow;
+    // RX delivery: frame-paced coalescing (see SerialWorker::DeliveryMode)
+    bool rxFramePaced_ = true;
+    int rxFrameIntervalMs_ = 16;
+    int rxFlushBudgetKiB_ = 256;
+    quint64 lastDeliveryCount_ = 0;
+    // Serial backend (see SerialWorker::Backend) and native tty options
+    bool nativeBackend_ = false;
+    int nativeVmin_ = 1;
+    int nativeVtime_ = 0;
+    bool nativeLowLatency_ = true;
+    // Large reads / large RX ring for multi-megabaud streams
+    bool throughputMode_ = false;
+    // How received bytes are split into frames for the plotter and timeline
+    Framer::Kind rxFraming_ = Framer::Kind::LineOrEtx;
+    // Log text kept in memory; older lines spill to log/ (0 = unlimited)
+    int scrollbackMiB_ = 256;
+    bool scrollbackErrorShown_ = false;
+    // Log text streamed to log/ as it arrives, with rotation, retention and
+    // fsync policy. Opt-in, like the auto-save on exit it replaces.
+    LogFileWriter logWriter_;
+    bool logToDisk_ = false;
+    int logRotateMiB_ = 64;         // 0 = no size limit
+    int logRotateMinutes_ = 60;     // 0 = no age limit
+    int logKeepFiles_ = 0;          // 0 = no file count limit
+    int logKeepMiB_ = 1024;         // 0 = no total size limit
+    LogFileWriter::SyncPolicy logSync_ = LogFileWriter::SyncPolicy::Interval;
+    QString logWriterErrorShown_;
+    // Raw RX/TX with timestamps, recorded to log/capture_*.sgcap
+    CaptureWriter capture_;
+    bool captureToDisk_ = false;
+    QString captureErrorShown_;
+    quint64 lastRxByteCount_ = 0;
+    quint64 lastTxByteCount_ = 0;
+
+    // pty loopback traffic generator for throughput benchmarking
+    TrafficGenerator *generator_ = nullptr;
+    bool generatorRamp_ = false;         // raise the rate until the app falls behind
+    qint64 generatorStartNs_ = 0;
+    quint64 generatorLastReceived_ = 0;   // bytes read and kept by the RX ring
+    quint64 generatorLastDropped_ = 0;
+    double generatorSustained_ = 0.0;    // best bytes/s the app kept up with
+    void openTrafficGenerator();
+    void stopTrafficGenerator(const QString &reason = QString());
+    void updateTrafficGenerator();
+
+    // Capture replay through the live RX path, at N x real time or flat out
+    CaptureReplay *replay_ = nullptr;
+    QVector<PortSession *> replaySessions_;   // the recorded ports; no worker
+    void openReplay();
+    PortSession *replaySession(const QString &port);
+    void onReplayFinished(bool stopped);
 
     // Settings management
     void openSettings();
     void saveSettings();
     void loadSettings();
+    void applyRxDeliverySettings();
+    void applyScrollbackSettings();
+    // (Re)start or stop logWriter_ to match the settings
+    void applyLogWriterSettings();
+    // Open or close capture_ to match the settings
+    void applyCaptureSettings();
     void saveQuickGroupLabels();
     void loadQuickGroupLabels();
     // Highlight rules UI
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <QDeadlineTimer>
+#include <QString>
+#include <QThread>
+#include <functional>
+#include <vector>
+
+// Linux serial backend that drives the tty with termios and epoll directly,
+// bypassing QSerialPort's event loop and internal buffering. A dedicated
+// reader thread sits in epoll_wait and hands bytes to a callback as soon as
+// the kernel has them. On other platforms open() always fails.
+class NativeSerialPort
+{
+public:
+    // Longest the reader sleeps in epoll_wait, idle or not
+    static const int kPollMs = 100;
+    // Quiet gap that delivers a group short of VMIN when VTIME is 0
+    static const int kTailMs = 5;
+
+    struct Options {
+        // Hand bytes on in groups of at least VMIN, or whatever has come in
+        // once the line has been quiet for VTIME tenths of a second (a few
+        // ms if 0). The reader thread applies them, not the tty.
+        // VMIN<=1 is lowest latency.
+        int vmin = 1;
+        int vtime = 0;
+        // Set ASYNC_LOW_LATENCY where the driver supports it
+        bool lowLatency = true;
+        // RTS/CTS hardware flow control
+        bool hardwareFlowControl = false;
+        // Bytes per read() call; raise for multi-megabaud streams
+        int readChunkSize = 64 * 1024;
+    };
+
+    using ReadHandler = std::function<void(const char *data, qint64 len)>;
+    using ErrorHandler = std::function<void(const QString &msg)>;
+    // Called on the reader thread after kickWriter() or when the tty becomes
+    // writable again after requestWritable()
+    using WritableHandler = std::function<void()>;
+
+    NativeSerialPort() = default;
+    ~NativeSerialPort();
+
+    // portName may be "ttyUSB0" or a full path such as "/dev/pts/3".
+    // Any baud rate is accepted; non-standard rates go through termios2.
+    // Handlers are called on the reader thread.
+    bool open(const QString &portName, int baudrate, const Options &opts,
+              ReadHandler onRead, ErrorHandler onError);
+    void close();
+    bool isOpen() const { return fd_ >= 0; }
+
+    void setWritableHandler(WritableHandler onWritable) { onWritable_ = std::move(onWritable); }
+
+    // Non-blocking write: returns bytes accepted by the kernel (0 when its
+    // TX buffer is full) or -1 on error
+    qint64 writeSome(const char *data, qint64 len);
+    // Run the writable handler on the reader thread as soon as possible
+    void kickWriter();
+    // Run the writable handler once the kernel TX buffer has room again
+    void requestWritable();
+    void clear(bool input, bool output);
+
+    QString errorString() const { return error_; }
+    bool lowLatencyActive() const { return lowLatencyActive_; }
+
+private:
+    void readLoop();
+    bool drainInput();
+    // Group bytes by VMIN before handing them to onRead_
+    void deliver(const char *data, qint64 len);
+    void flushHeld();
+    void fail(const QString &what);
+    bool setCustomBaudRate(int baudrate);
+
+    int fd_ = -1;
+    int epollFd_ = -1;
+    int wakeFd_ = -1;    // eventfd used to stop the reader
+    int txFd_ = -1;      // eventfd used by kickWriter()
+    QThread *reader_ = nullptr;
+    Options opts_;
+    ReadHandler onRead_;
+    ErrorHandler onError_;
+    WritableHandler onWritable_;
+    std::vector<char> scratch_;
+    std::vector<char> held_;       // reader thread: a group short of VMIN
+    QDeadlineTimer heldUntil_;     // when held_ goes out anyway
+    QString error_;
+    bool lowLatencyActive_ = false;
+};
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <QAtomicInt>
+#include <QByteArray>
+#include <QMetaType>
+#include <QMutex>
+
+// Fixed-size receive blocks handed out by RxBufferPool. Blocks are recycled
+// through a free list, so steady-state reception does not touch the heap.
+struct RxBlock
+{
+    static const int kSize = 256 * 1024;
+
+    QAtomicInt ref;
+    RxBlock *next = nullptr;
+    char data[kSize];
+};
+
+// Reference-counted, read-only view into a pooled receive block. Copying a
+// chunk only bumps the count; the block goes back to the pool when the last
+// view is released. The log, framer and plotter all read the same bytes.
+class RxChunk
+{
+public:
+    RxChunk() = default;
+    RxChunk(const RxChunk &other);
+    RxChunk(RxChunk &&other) noexcept;
+    RxChunk &operator=(const RxChunk &other);
+    RxChunk &operator=(RxChunk &&other) noexcept;
+    ~RxChunk();
+
+    const char *data() const { return block_ ? block_->data + offset_ : nullptr; }
+    int size() const { return size_; }
+    bool isEmpty() const { return size_ == 0; }
+    qint64 timestampNs() const { return timestampNs_; }
+
+    // Sub-view sharing the same block (no copy)
+    RxChunk mid(int pos, int len) const;
+
+    // Non-owning QByteArray over the chunk bytes; valid while this chunk lives
+    QByteArray bytes() const { return QByteArray::fromRawData(data(), size_); }
+
+private:
+    friend class RxBufferPool;
+    RxChunk(RxBlock *block, int offset, int size, qint64 timestampNs);
+    void release();
+
+    RxBlock *block_ = nullptr;
+    int offset_ = 0;
+    int size_ = 0;
+    qint64 timestampNs_ = 0;
+};
+
+Q_DECLARE_METATYPE(RxChunk)
+
+class RxBufferPool
+{
+public:
+    struct Stats {
+        int totalBlocks = 0;   // blocks ever allocated
+        int inUse = 0;         // blocks currently referenced by chunks
+        int peakInUse = 0;
+        quint64 acquires = 0;  // blocks handed out
+        quint64 misses = 0;    // acquires that had to allocate a new block
+    };
+
+    // Process-wide pool shared by all workers
+    static RxBufferPool &instance();
+
+    // Take a writable block. Fill block->data, then wrap() it.
+    RxBlock *acquire();
+    // Turn the first len bytes of an acquired block into a chunk.
+    RxChunk wrap(RxBlock *block, int len, qint64 timestampNs);
+    // Return a block that was acquired but not wrapped.
+    void recycle(RxBlock *block);
+
+    Stats stats() const;
+
+private:
+    explicit RxBufferPool(int preallocate);
+    ~RxBufferPool();
+    friend class RxChunk;
+
+    mutable QMutex mutex_;
+    RxBlock *free_ = nullptr;
+    Stats stats_;
+};
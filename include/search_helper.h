@@ -1,6 +1,7 @@
 #pragma once
 
 #include <QString>
+#include <QStringList>
 #include <QVector>
 #include <QPair>
 #include <QTextDocument>
@@ -14,4 +15,24 @@ namespace SearchHelper {
 
     // Find previous occurrence index < from (or -1 if not found)
     int findPrevious(const QString &text, const QString &term, int from, Qt::CaseSensitivity cs = Qt::CaseSensitive);
+
+    // Byte search over UTF-8 text such as the log store's chunks. Uses AVX2
+    // or SSE2 when the CPU has them, picked once at runtime, else plain C.
+    enum Option {
+        CaseInsensitive = 0x1,  // ASCII letters only
+        WholeWords = 0x2        // ASCII letters, digits and '_' are word characters; so is any byte >= 0x80
+    };
+
+    // First / last match lying entirely inside [begin, end), or nullptr.
+    // Word boundaries are checked against the bytes inside the range only.
+    const char *find(const char *begin, const char *end, const char *needle, int needleLen, int options = 0);
+    const char *findLast(const char *begin, const char *end, const char *needle, int needleLen, int options = 0);
+
+    // "AVX2", "SSE2" or "scalar"
+    const char *backendName();
+    // Backends this CPU can run, fastest (the default) first
+    QStringList backends();
+    // Use the named backend from now on, e.g. to compare them in a
+    // benchmark; false if it is unknown or the CPU lacks it
+    bool setBackend(const QString &name);
 }
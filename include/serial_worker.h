@@ -1,30 +1,159 @@
 #pragma once
 
 #include <QObject>
+#include <QMutex>
 #include <QSerialPort>
+#include <QThread>
+#include <atomic>
+#include "spsc_ring_buffer.h"
+#include "spsc_queue.h"
+#include "rx_buffer_pool.h"
+#include "native_serial_port.h"
 
+class QTimer;
+
+// Serial port front-end. The SerialWorker object itself lives on the caller's
+// (GUI) thread, but the QSerialPort and all reads run on a dedicated I/O
+// thread. Received bytes are pushed into a lock-free ring and drained on the
+// GUI thread, so a busy GUI never stalls the port.
 class SerialWorker : public QObject
 {
     Q_OBJECT
 public:
+    // How drained RX data is handed to dataReceived():
+    //  Immediate  - one emission per wake-up from the I/O thread
+    //  FramePaced - gathered and emitted at most once per frame interval,
+    //               up to flushBudget bytes per emission
+    enum class DeliveryMode { Immediate, FramePaced };
+
+    // Port implementation chosen at openPort() time:
+    //  QtSerialPort - QSerialPort on the worker's I/O thread (portable)
+    //  NativeLinux  - termios + epoll reader thread (Linux, low latency)
+    enum class Backend { QtSerialPort, NativeLinux };
+
+    struct PortSettings {
+        int baudRate = 115200;             // any rate the driver accepts
+        bool hardwareFlowControl = false;  // RTS/CTS
+        // Large reads and a large RX ring for multi-megabaud streams
+        bool throughputMode = false;
+        Backend backend = Backend::QtSerialPort;
+    };
+
     explicit SerialWorker(QObject *parent = nullptr);
     ~SerialWorker();
 
-    bool openPort(const QString &portName, int baudrate = 115200);
+    // Clock used for RxChunk::timestampNs(), shared by all workers
+    static qint64 monotonicNs();
+
+    void setDeliveryMode(DeliveryMode mode) { deliveryMode_ = mode; }
+    DeliveryMode deliveryMode() const { return deliveryMode_; }
+    void setFrameInterval(int ms);
+    int frameInterval() const;
+    void setFlushBudget(qint64 bytes) { flushBudget_ = bytes; } // 0 = unlimited
+    qint64 flushBudget() const { return flushBudget_; }
+
+    bool openPort(const QString &portName, const PortSettings &settings);
+    bool openPort(const QString &portName, int baudrate = 115200,
+                  Backend backend = Backend::QtSerialPort);
     void closePort();
+    // Queue data for transmission; never blocks. Returns false (and queues
+    // nothing) if the port is closed or the TX queue is above its high-water
+    // mark; txQueueLow() is emitted once it has drained below the low-water
+    // mark again. A message larger than the high-water mark is taken when the
+    // queue is empty. Thread-safe.
     bool sendData(const QByteArray &data);
-    bool isOpen() const { return serial_.isOpen(); }
+    bool isOpen() const { return open_.load(); }
     void clearBuffer();
 
+    // VMIN/VTIME and low-latency options used by the NativeLinux backend
+    void setNativeOptions(const NativeSerialPort::Options &opts) { nativeOpts_ = opts; }
+    NativeSerialPort::Options nativeOptions() const { return nativeOpts_; }
+    Backend backend() const { return backend_; }
+    bool lowLatencyActive() const { return native_.lowLatencyActive(); }
+
+    // RX hand-off ring (fill level / overflow counters)
+    const SpscRingBuffer &rxRing() const { return rxRing_; }
+    // Number of dataReceived emissions so far
+    quint64 deliveryCount() const { return deliveries_; }
+    // Total bytes read from the port (before any ring overflow)
+    quint64 rxByteCount() const { return rxBytes_.load(std::memory_order_relaxed); }
+
+    // TX queue: high-water mark for sendData(), low water is a quarter of it
+    void setTxHighWaterMark(qint64 bytes);
+    qint64 txHighWaterMark() const { return txHighWater_; }
+    qint64 txQueueDepth() const { return txRing_.size() + txOverflowLeft_.load(); }
+    // Bytes handed to the driver / bytes accepted by sendData() / rejected sends
+    quint64 txBytesWritten() const { return txWritten_.load(std::memory_order_relaxed); }
+    quint64 txBytesQueued() const { return txQueued_.load(std::memory_order_relaxed); }
+    quint64 txRejectedCount() const { return txRejected_.load(std::memory_order_relaxed); }
+
 signals:
-    void dataReceived(const QByteArray &data);
+    // Chunk is a pooled, reference-counted view; copy it to keep the bytes
+    void dataReceived(const RxChunk &chunk);
     void portOpened();
     void portClosed();
     void errorOccurred(const QString &msg);
+    // TX queue has dropped below the low-water mark after sendData() refused data
+    void txQueueLow();
 
 private slots:
-    void handleReadyRead();
+    void onRxNotify();
+    void onFrameTick();
 
 private:
-    QSerialPort serial_;
+    // Runs on the I/O thread
+    void handleReadyRead();
+    // Producer side shared by both backends: push into the ring, wake the GUI
+    void onBytesRead(const char *data, qint64 len);
+    // Consumer side of the TX ring. Runs on the I/O thread (Qt backend) or
+    // the native reader thread; writes until the driver pushes back.
+    void drainTx();
+    // Move the rest of an oversize message into the ring as it drains.
+    // Returns true if some of it is still waiting.
+    bool refillTx();
+    // Hand what is in the ring to the driver until it pushes back
+    void drainTxRing();
+    void onTxProgress();
+    // GUI thread: emit up to budget bytes (0 = all) as pooled chunks.
+    // Returns false if the ring was empty.
+    bool drainRx(qint64 budget);
+
+    QThread ioThread_;
+    QObject *io_ = nullptr;          // context object living on ioThread_
+    QSerialPort *serial_ = nullptr;  // created and used on ioThread_ only
+    QByteArray readScratch_;         // I/O thread only
+
+    NativeSerialPort native_;        // reader runs on its own thread
+    NativeSerialPort::Options nativeOpts_;
+    Backend backend_ = Backend::QtSerialPort;
+
+    SpscRingBuffer rxRing_;
+    // Arrival time of each read, keyed by the ring offset where it ends.
+    // Lets every delivered chunk carry the time its first byte arrived.
+    struct RxMark {
+        quint64 streamEnd;
+        qint64 timestampNs;
+    };
+    SpscQueue<RxMark> rxMarks_;
+    std::atomic<bool> open_{false};
+    std::atomic<bool> drainPending_{false};
+    std::atomic<quint64> rxBytes_{0};
+
+    SpscRingBuffer txRing_{1024 * 1024};
+    QMutex txProducerMutex_;         // sendData() may be called from several threads
+    QByteArray txOverflow_;          // part of an oversize message not in the ring yet
+    int txOverflowPos_ = 0;          // (both under txProducerMutex_)
+    std::atomic<qint64> txOverflowLeft_{0};
+    QByteArray txScratch_;           // drainTx() only
+    qint64 txHighWater_ = 512 * 1024;
+    std::atomic<bool> txKickPending_{false};
+    std::atomic<bool> txBlocked_{false};   // sendData() refused since last low water
+    std::atomic<quint64> txWritten_{0};
+    std::atomic<quint64> txQueued_{0};
+    std::atomic<quint64> txRejected_{0};
+
+    DeliveryMode deliveryMode_ = DeliveryMode::FramePaced;
+    QTimer *frameTimer_ = nullptr;
+    qint64 flushBudget_ = 256 * 1024;
+    quint64 deliveries_ = 0;
 };
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <QtGlobal>
+#include <atomic>
+#include <vector>
+
+// Bounded single-producer / single-consumer queue of small POD records.
+// Companion to SpscRingBuffer for per-read metadata such as timestamps.
+template <typename T>
+class SpscQueue
+{
+public:
+    explicit SpscQueue(int capacity = 4096)
+    {
+        int cap = 2;
+        while (cap < capacity)
+            cap <<= 1;
+        items_.resize(size_t(cap));
+        mask_ = quint64(cap - 1);
+    }
+
+    // Producer side. Returns false (and drops the record) when full.
+    bool push(const T &item)
+    {
+        const quint64 head = head_.load(std::memory_order_relaxed);
+        if (head - tail_.load(std::memory_order_acquire) > mask_)
+            return false;
+        items_[head & mask_] = item;
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side
+    bool peek(T &out) const
+    {
+        const quint64 tail = tail_.load(std::memory_order_relaxed);
+        if (tail == head_.load(std::memory_order_acquire))
+            return false;
+        out = items_[tail & mask_];
+        return true;
+    }
+    void pop()
+    {
+        const quint64 tail = tail_.load(std::memory_order_relaxed);
+        if (tail != head_.load(std::memory_order_acquire))
+            tail_.store(tail + 1, std::memory_order_release);
+    }
+
+    // Only while neither side is active
+    void reset()
+    {
+        head_.store(0, std::memory_order_relaxed);
+        tail_.store(0, std::memory_order_relaxed);
+    }
+
+private:
+    std::vector<T> items_;
+    quint64 mask_ = 0;
+    alignas(64) std::atomic<quint64> head_{0};
+    alignas(64) std::atomic<quint64> tail_{0};
+};
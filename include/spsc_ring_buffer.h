@@ -0,0 +1,56 @@
+#pragma once
+
+#include <QtGlobal>
+#include <atomic>
+#include <vector>
+
+// Bounded single-producer / single-consumer byte ring.
+// Exactly one thread may call write() and exactly one other thread may call
+// read()/clear(). Neither side ever blocks: when the ring is full, write()
+// stores what fits and counts the rest as dropped.
+class SpscRingBuffer
+{
+public:
+    explicit SpscRingBuffer(qint64 capacity = 4 * 1024 * 1024);
+
+    // Producer side. Returns the number of bytes stored (may be < len).
+    qint64 write(const char *data, qint64 len);
+
+    // Consumer side. Returns the number of bytes copied into out.
+    qint64 read(char *out, qint64 maxLen);
+    // Consumer side. Copy without consuming, then skip() what was used.
+    qint64 peek(char *out, qint64 maxLen) const;
+    void skip(qint64 len);
+    // Consumer side. Drop everything currently queued.
+    void clear();
+
+    // Change capacity (rounded up to a power of two). Only call while no
+    // producer or consumer is active, e.g. before the port is opened.
+    void resize(qint64 capacity);
+
+    qint64 capacity() const { return qint64(mask_ + 1); }
+    qint64 size() const;
+    // Monotonic stream offsets: bytes ever stored / ever consumed
+    quint64 totalWritten() const { return head_.load(std::memory_order_acquire); }
+    quint64 totalRead() const { return tail_.load(std::memory_order_acquire); }
+    qint64 peakSize() const { return peak_.load(std::memory_order_relaxed); }
+    double fillRatio() const { return double(size()) / double(capacity()); }
+
+    // Number of writes that could not store everything, and bytes lost.
+    quint64 overflowCount() const { return overflows_.load(std::memory_order_relaxed); }
+    quint64 droppedBytes() const { return dropped_.load(std::memory_order_relaxed); }
+    void resetStats();
+
+private:
+    std::vector<char> buf_;
+    quint64 mask_ = 0;
+
+    // Producer and consumer indices live on separate cache lines so the two
+    // threads do not invalidate each other on every update.
+    alignas(64) std::atomic<quint64> head_{0};   // written by producer
+    alignas(64) std::atomic<quint64> tail_{0};   // written by consumer
+
+    alignas(64) std::atomic<qint64> peak_{0};
+    std::atomic<quint64> overflows_{0};
+    std::atomic<quint64> dropped_{0};
+};
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+#include <QThread>
+#include <atomic>
+
+// Synthetic serial traffic for end-to-end benchmarking. start() creates a
+// pseudo-terminal pair and a writer thread that streams a pattern into the
+// master side at a configured rate; the app opens slavePath() like any other
+// serial port. Anything the app transmits is read and discarded. Linux only;
+// on other platforms start() always fails.
+class TrafficGenerator
+{
+public:
+    enum class Pattern {
+        Text,         // Numbered ASCII lines
+        Telemetry,    // "key:value,..." lines as parsed by the plotter
+        Binary,       // Random bytes
+        Burst         // Telemetry lines released in 100 ms bursts
+    };
+
+    TrafficGenerator() = default;
+    ~TrafficGenerator();
+
+    bool start(Pattern pattern, qint64 bytesPerSec);
+    void stop();
+    bool isRunning() const { return writer_ != nullptr; }
+
+    // Takes effect immediately; the schedule continues from the current point
+    void setRate(qint64 bytesPerSec);
+    qint64 rate() const { return rate_.load(); }
+
+    QString slavePath() const { return slavePath_; }
+    QString errorString() const { return error_; }
+
+    quint64 bytesWritten() const { return written_.load(); }
+    // Bytes the schedule called for that the pty would not take yet, i.e.
+    // how far the reader (the app) is behind
+    qint64 lagBytes() const { return lag_.load(); }
+    // write() calls that found the pty full
+    quint64 stallCount() const { return stalls_.load(); }
+
+private:
+    void writeLoop();
+    void generate(QByteArray &out, qint64 minBytes);
+    void fail(const QString &what);
+
+    int masterFd_ = -1;
+    int slaveFd_ = -1;     // held open so the pty survives the app reopening it
+    QString slavePath_;
+    QThread *writer_ = nullptr;
+    Pattern pattern_ = Pattern::Text;
+    quint64 seq_ = 0;      // writer thread only
+    QString error_;
+
+    std::atomic<bool> stop_{false};
+    std::atomic<qint64> rate_{0};
+    std::atomic<quint64> written_{0};
+    std::atomic<qint64> lag_{0};
+    std::atomic<quint64> stalls_{0};
+};
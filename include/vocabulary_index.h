@@ -0,0 +1,47 @@
+#pragma once
+
+#include <QByteArray>
+#include <QStringList>
+#include <map>
+
+// Word counts of the log text for the search completer, fed with each
+// append instead of re-splitting the whole log. Words are runs of ASCII
+// letters, digits and '_' plus any non-ASCII UTF-8 bytes (the \w of the old
+// QRegExp split, near enough). Keys are lower-cased ASCII so a prefix
+// query is one ordered range of the map; each key remembers the spelling
+// it was first seen with.
+class VocabularyIndex
+{
+public:
+    // Beyond this many distinct words only the counts of known words grow,
+    // so hex dumps and counters cannot take over memory
+    static const int kMaxWords = 200000;
+    // Longer runs are data, not words
+    static const int kMaxWordLength = 64;
+    // Shorter prefixes match too much of the log to be worth a query
+    static const int kMinPrefix = 2;
+    // Entries of the prefix range looked at per query; past this the most
+    // frequent words among those seen are returned
+    static const int kMaxScan = 20000;
+
+    // A word cut off at the end of the data is held back until the next
+    // append tells whether it goes on
+    void addUtf8(const char *data, int size);
+    void clear();
+
+    // Up to count words starting with prefix (ASCII case-insensitive),
+    // most frequent first; none for prefixes shorter than kMinPrefix
+    QStringList topMatches(const QString &prefix, int count) const;
+
+    int wordCount() const { return int(words_.size()); }
+
+private:
+    struct Entry {
+        QByteArray word;
+        quint32 count = 0;
+    };
+    void addWord(const char *word, int size);
+
+    std::map<QByteArray, Entry> words_;
+    QByteArray partial_;
+};
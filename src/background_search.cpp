@@ -0,0 +1,164 @@
+#include "background_search.h"
+#include "search_helper.h"
+#include <QFile>
+#include <QRunnable>
+#include <atomic>
+#include <cstring>
+#include <functional>
+
+struct BackgroundSearch::State
+{
+    LogLineStore::Snapshot snapshot;
+    QByteArray needle;
+    std::atomic<int> nextBlock{0};
+    std::atomic<bool> cancelled{false};
+};
+
+namespace {
+
+// UTF-16 length of a UTF-8 byte range
+int utf16Length(const char *data, int size)
+{
+    for (int i = 0; i < size; ++i) {
+        if (uchar(data[i]) >= 0x80)
+            return QString::fromUtf8(data, size).size();
+    }
+    return size;
+}
+
+QVector<LogView::Position> searchBlock(const QByteArray &data, quint64 firstLine, const QByteArray &needle)
+{
+    QVector<LogView::Position> out;
+    const char *begin = data.constData();
+    const char *end = begin + data.size();
+    // Lines and the UTF-16 column are counted up to counted, so each byte is
+    // looked at once however many matches share a long line
+    const char *counted = begin;
+    quint64 line = firstLine;
+    int column = 0;
+    for (const char *p = begin; (p = SearchHelper::find(p, end, needle.constData(), needle.size())); p += needle.size()) {
+        // Count the lines passed since the last match
+        while (const char *nl = static_cast<const char *>(memchr(counted, '\n', size_t(p - counted)))) {
+            ++line;
+            counted = nl + 1;
+            column = 0;
+        }
+        column += utf16Length(counted, int(p - counted));
+        counted = p;
+        out.append({line, column});
+    }
+    return out;
+}
+
+class SearchTask : public QRunnable
+{
+public:
+    using Post = std::function<void(int, const QVector<LogView::Position> &)>;
+
+    SearchTask(std::shared_ptr<BackgroundSearch::State> state, Post post)
+        : state_(std::move(state)), post_(std::move(post))
+    {
+    }
+
+    void run() override;
+
+private:
+    std::shared_ptr<BackgroundSearch::State> state_;
+    Post post_;
+};
+
+} // namespace
+
+void SearchTask::run()
+{
+    const LogLineStore::Snapshot &snap = state_->snapshot;
+    QFile spill(snap.spillPath);
+    const int total = int(snap.blocks.size());
+    for (int i = state_->nextBlock++; i < total && !state_->cancelled.load(); i = state_->nextBlock++) {
+        const LogLineStore::Snapshot::Block &block = snap.blocks[size_t(i)];
+        QByteArray data = block.data;
+        if (block.spillOffset >= 0 && data.isEmpty()) {
+            if (!spill.isOpen())
+                spill.open(QIODevice::ReadOnly);
+            if (spill.seek(block.spillOffset))
+                data = spill.read(block.spillSize);
+        }
+        post_(i, searchBlock(data, block.firstLine, state_->needle));
+    }
+}
+
+BackgroundSearch::BackgroundSearch(QObject *parent)
+    : QObject(parent)
+{
+}
+
+BackgroundSearch::~BackgroundSearch()
+{
+    cancel();
+    pool_.waitForDone();
+}
+
+void BackgroundSearch::start(const LogLineStore &store, const QString &term)
+{
+    cancel();
+    term_ = term;
+    pending_.clear();
+    nextBlock_ = 0;
+    blocksDone_ = 0;
+    matchCount_ = 0;
+
+    auto state = std::make_shared<State>();
+    state->snapshot = store.snapshot();
+    state->needle = term.toUtf8();
+    if (state->needle.isEmpty() || state->needle.contains('\n'))
+        state->snapshot.blocks.clear();
+    state_ = state;
+
+    const int blocks = int(state->snapshot.blocks.size());
+    if (blocks == 0) {
+        state_.reset();
+        emit finished(0);
+        return;
+    }
+    auto post = [this, state](int block, const QVector<LogView::Position> &matches) {
+        QMetaObject::invokeMethod(this, [this, state, block, matches]() { blockDone(state, block, matches); },
+                                  Qt::QueuedConnection);
+    };
+    const int threads = qMin(blocks, qMax(1, pool_.maxThreadCount()));
+    for (int i = 0; i < threads; ++i)
+        pool_.start(new SearchTask(state, post));
+}
+
+void BackgroundSearch::cancel()
+{
+    if (state_)
+        state_->cancelled.store(true);
+    state_.reset();
+    pending_.clear();
+}
+
+void BackgroundSearch::blockDone(const std::shared_ptr<State> &state, int block,
+                                 const QVector<LogView::Position> &matches)
+{
+    if (state != state_)
+        return;     // from a cancelled search
+
+    ++blocksDone_;
+    matchCount_ += matches.size();
+    pending_.insert(block, matches);
+    // Hand out everything that is now contiguous from the top
+    QVector<LogView::Position> ready;
+    for (auto it = pending_.begin(); it != pending_.end() && it.key() == nextBlock_; it = pending_.erase(it)) {
+        ready += it.value();
+        ++nextBlock_;
+    }
+    if (!ready.isEmpty())
+        emit matchesFound(ready);
+
+    const int total = int(state->snapshot.blocks.size());
+    emit progress(blocksDone_, total, matchCount_);
+    if (blocksDone_ == total) {
+        state_.reset();
+        emit finished(matchCount_);
+    }
+}
@@ -0,0 +1,204 @@
+#include "batch_scheduler.h"
+#include "serial_worker.h"
+
+#include <QDeadlineTimer>
+#include <QRandomGenerator>
+#include <QThread>
+#include <algorithm>
+
+BatchScheduler::BatchScheduler(QObject *parent)
+    : QObject(parent)
+{
+}
+
+BatchScheduler::~BatchScheduler()
+{
+    cancel();
+}
+
+bool BatchScheduler::start(SerialWorker *worker, const QVector<BatchStep> &steps)
+{
+    if (isRunning() || !worker)
+        return false;
+
+    if (thread_) {
+        thread_->wait();
+        delete thread_;
+        thread_ = nullptr;
+    }
+
+    worker_ = worker;
+    steps_ = steps;
+    {
+        QMutexLocker lock(&mutex_);
+        paused_ = false;
+        cancelled_ = false;
+        txLow_ = false;
+    }
+    // Emitted on the worker's I/O thread
+    disconnect(txLowConnection_);
+    txLowConnection_ = connect(worker, &SerialWorker::txQueueLow, this, [this]() {
+        QMutexLocker lock(&mutex_);
+        txLow_ = true;
+        cond_.wakeAll();
+    }, Qt::DirectConnection);
+
+    thread_ = QThread::create([this]() { run(); });
+    thread_->setObjectName("BatchScheduler");
+    thread_->start(QThread::HighPriority);
+    return true;
+}
+
+void BatchScheduler::pause()
+{
+    QMutexLocker lock(&mutex_);
+    paused_ = true;
+    cond_.wakeAll();
+}
+
+void BatchScheduler::resume()
+{
+    QMutexLocker lock(&mutex_);
+    paused_ = false;
+    cond_.wakeAll();
+}
+
+void BatchScheduler::cancel()
+{
+    {
+        QMutexLocker lock(&mutex_);
+        cancelled_ = true;
+        cond_.wakeAll();
+    }
+    if (thread_) {
+        thread_->wait();
+        delete thread_;
+        thread_ = nullptr;
+    }
+    disconnect(txLowConnection_);
+}
+
+bool BatchScheduler::isRunning() const
+{
+    return thread_ && thread_->isRunning();
+}
+
+bool BatchScheduler::isPaused() const
+{
+    QMutexLocker lock(&mutex_);
+    return paused_;
+}
+
+bool BatchScheduler::waitUntil(qint64 &deadlineNs)
+{
+    QMutexLocker lock(&mutex_);
+    while (!cancelled_) {
+        if (paused_) {
+            const qint64 pauseStart = SerialWorker::monotonicNs();
+            while (paused_ && !cancelled_)
+                cond_.wait(&mutex_);
+            // Shift the schedule so the script resumes where it left off
+            deadlineNs += SerialWorker::monotonicNs() - pauseStart;
+            continue;
+        }
+        const qint64 remainNs = deadlineNs - SerialWorker::monotonicNs();
+        if (remainNs <= 0)
+            return true;
+        QDeadlineTimer timer(std::chrono::nanoseconds(remainNs), Qt::PreciseTimer);
+        cond_.wait(&mutex_, timer);
+    }
+    return false;
+}
+
+bool BatchScheduler::waitForTxRoom()
+{
+    QMutexLocker lock(&mutex_);
+    // The poll covers a txQueueLow that went to another sender's retry
+    if (!cancelled_ && !txLow_)
+        cond_.wait(&mutex_, QDeadlineTimer(100, Qt::PreciseTimer));
+    txLow_ = false;
+    return !cancelled_;
+}
+
+void BatchScheduler::run()
+{
+    const int total = steps_.size();
+    qint64 deadline = SerialWorker::monotonicNs();
+    startNs_.store(deadline);
+    int sent = 0;
+    double jitterSumUs = 0.0;
+    double jitterMaxUs = 0.0;
+    bool cancelled = false;
+
+    emit progress(0, total);
+    for (int i = 0; i < total; ++i) {
+        const BatchStep &step = steps_.at(i);
+
+        switch (step.kind) {
+        case BatchStep::Comment:
+            emit message(QString("# %1\n").arg(step.text));
+            break;
+
+        case BatchStep::Delay:
+            emit message(QString("%1\n").arg(step.text));
+            deadline += qint64(step.delayMs * 1e6);
+            break;
+
+        case BatchStep::RandomDelay: {
+            const quint32 ms = QRandomGenerator::global()->bounded(step.minMs, step.maxMs + 1);
+            emit message(QString("Random Delay %1 ms (range %2-%3 ms)\n").arg(ms).arg(step.minMs).arg(step.maxMs));
+            deadline += qint64(ms) * 1000000;
+            break;
+        }
+
+        case BatchStep::Send: {
+            if (!waitUntil(deadline)) {
+                cancelled = true;
+                break;
+            }
+            {
+                QMutexLocker lock(&mutex_);
+                txLow_ = false;
+            }
+            qint64 actual = SerialWorker::monotonicNs();
+            bool ok = worker_->sendData(step.payload);
+            if (!ok && worker_->isOpen()) {
+                // Queue full: wait for it to drain instead of giving up;
+                // the time waited shows as jitter of this send
+                emit message(QString("TX queue full, waiting to send: %1\n").arg(step.text));
+                while (!ok && worker_->isOpen()) {
+                    if (!waitForTxRoom()) {
+                        cancelled = true;
+                        break;
+                    }
+                    actual = SerialWorker::monotonicNs();
+                    ok = worker_->sendData(step.payload);
+                }
+                if (cancelled)
+                    break;
+            }
+            emit commandSent(step.text, step.payload, deadline, actual, ok);
+            if (!ok) {
+                emit message(QString("Port closed, batch stopped at: %1\n").arg(step.text));
+                cancelled = true;
+                break;
+            }
+            const double jitterUs = double(actual - deadline) / 1000.0;
+            jitterSumUs += jitterUs;
+            jitterMaxUs = std::max(jitterMaxUs, jitterUs);
+            ++sent;
+            break;
+        }
+        }
+
+        if (cancelled)
+            break;
+        emit progress(i + 1, total);
+    }
+
+    // Honour a trailing delay so the script's total duration is preserved
+    if (!cancelled && !waitUntil(deadline))
+        cancelled = true;
+
+    emit finished(cancelled, sent, sent ? jitterSumUs / sent : 0.0, jitterMaxUs);
+}
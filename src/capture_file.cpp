@@ -0,0 +1,451 @@
+#include "capture_file.h"
+#include "serial_worker.h"
+
+#include <QDateTime>
+#include <QDeadlineTimer>
+#include <QThread>
+#include <QtEndian>
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+const char kFileMagic[8] = {'S', 'G', 'C', 'A', 'P', 0, 0, 1};
+const char kBlockMagic[4] = {'S', 'G', 'B', 'K'};
+const char kIndexMagic[4] = {'S', 'G', 'I', 'X'};
+const char kEndMagic[8] = {'S', 'G', 'E', 'N', 'D', 0, 0, 0};
+const quint32 kVersion = 1;
+const int kFileHeaderSize = 8 + 4 + 8 + 8;
+const int kBlockHeaderSize = 4 + 4 + 4 + 4 + 4 + 8 + 8 + 8;
+const int kIndexEntrySize = 8 + kBlockHeaderSize - 4;
+const int kTrailerSize = 8 + 8;
+const int kRecordHeaderSize = 8 + 1 + 1 + 4;
+// Unsealed data older than this is written out, bounding what a crash loses
+const qint64 kMaxBlockAgeMs = 1000;
+
+template <typename T>
+void put(QByteArray &out, T value)
+{
+    char buf[sizeof(T)];
+    qToLittleEndian(value, buf);
+    out.append(buf, int(sizeof(T)));
+}
+
+template <typename T>
+T get(const char *p)
+{
+    return qFromLittleEndian<T>(p);
+}
+
+// Block header fields after the magic, shared by blocks and index entries
+void putBlockFields(QByteArray &out, const Capture::BlockInfo &b)
+{
+    put<quint32>(out, b.compressedSize);
+    put<quint32>(out, b.rawSize);
+    put<quint32>(out, b.records);
+    put<quint32>(out, b.payloadSize);
+    put<qint64>(out, b.firstTimestampNs);
+    put<qint64>(out, b.lastTimestampNs);
+    put<quint64>(out, b.firstByte);
+}
+
+void getBlockFields(const char *p, Capture::BlockInfo &b)
+{
+    b.compressedSize = get<quint32>(p);
+    b.rawSize = get<quint32>(p + 4);
+    b.records = get<quint32>(p + 8);
+    b.payloadSize = get<quint32>(p + 12);
+    b.firstTimestampNs = get<qint64>(p + 16);
+    b.lastTimestampNs = get<qint64>(p + 24);
+    b.firstByte = get<quint64>(p + 32);
+}
+
+qint64 monotonicMs()
+{
+    return SerialWorker::monotonicNs() / 1000000;
+}
+
+} // namespace
+
+CaptureWriter::~CaptureWriter()
+{
+    close();
+}
+
+bool CaptureWriter::open(const QString &path, int level)
+{
+    if (isOpen())
+        return false;
+    file_.setFileName(path);
+    if (!file_.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        QMutexLocker lock(&mutex_);
+        error_ = file_.errorString();
+        return false;
+    }
+    QByteArray header(kFileMagic, sizeof(kFileMagic));
+    put<quint32>(header, kVersion);
+    put<qint64>(header, QDateTime::currentMSecsSinceEpoch());
+    put<qint64>(header, SerialWorker::monotonicNs());
+    if (file_.write(header) != header.size()) {
+        QMutexLocker lock(&mutex_);
+        error_ = file_.errorString();
+        file_.close();
+        return false;
+    }
+
+    path_ = path;
+    level_ = level;
+    index_.clear();
+    bytesIn_.store(0);
+    bytesWritten_.store(quint64(header.size()));
+    bytesDropped_.store(0);
+    {
+        QMutexLocker lock(&mutex_);
+        blockOpen_ = false;
+        queue_.clear();
+        ports_.clear();
+        portNames_.clear();
+        payloadBytes_ = 0;
+        stop_ = false;
+        error_.clear();
+    }
+
+    thread_ = QThread::create([this]() { run(); });
+    thread_->setObjectName("CaptureWriter");
+    thread_->start(QThread::LowPriority);
+    return true;
+}
+
+void CaptureWriter::close()
+{
+    if (!thread_)
+        return;
+    {
+        QMutexLocker lock(&mutex_);
+        sealBlock();
+        stop_ = true;
+        wake_.wakeAll();
+    }
+    thread_->wait();
+    delete thread_;
+    thread_ = nullptr;
+    writeIndex();
+    file_.close();
+}
+
+int CaptureWriter::portId(const QString &name)
+{
+    QMutexLocker lock(&mutex_);
+    auto it = ports_.constFind(name);
+    if (it != ports_.constEnd())
+        return it.value();
+    const int id = portNames_.size();
+    if (id >= kMaxPorts) {
+        error_ = QString("More than %1 ports in one capture; %2 is not recorded").arg(kMaxPorts).arg(name);
+        return -1;
+    }
+    ports_.insert(name, id);
+    portNames_.append(name);
+    if (blockOpen_) {
+        const QByteArray utf8 = name.toUtf8();
+        addRecord(Capture::Direction::PortName, id, current_.lastTimestampNs, utf8.constData(), utf8.size());
+    }
+    return id;
+}
+
+void CaptureWriter::append(Capture::Direction direction, int port, qint64 timestampNs, const char *data, int size)
+{
+    if (size <= 0 || !thread_)
+        return;
+    bytesIn_.fetch_add(quint64(size), std::memory_order_relaxed);
+    if (port < 0 || port >= kMaxPorts) {
+        bytesDropped_.fetch_add(quint64(size), std::memory_order_relaxed);
+        return;
+    }
+    QMutexLocker lock(&mutex_);
+    if (!blockOpen_) {
+        if (int(queue_.size()) >= kMaxQueuedBlocks) {
+            bytesDropped_.fetch_add(quint64(size), std::memory_order_relaxed);
+            return;
+        }
+        current_.firstTimestampNs = timestampNs;
+        beginBlock();
+    }
+    addRecord(direction, port, timestampNs, data, size);
+    current_.payloadSize += quint32(size);
+    payloadBytes_ += quint64(size);
+    if (current_.raw.size() >= kBlockBytes)
+        sealBlock();
+}
+
+void CaptureWriter::beginBlock()
+{
+    current_.raw.clear();
+    current_.raw.reserve(kBlockBytes + kBlockBytes / 4);
+    current_.records = 0;
+    current_.payloadSize = 0;
+    current_.lastTimestampNs = current_.firstTimestampNs;
+    current_.firstByte = payloadBytes_;
+    current_.sealAtMs = monotonicMs() + kMaxBlockAgeMs;
+    blockOpen_ = true;
+    for (int id = 0; id < portNames_.size(); ++id) {
+        const QByteArray utf8 = portNames_[id].toUtf8();
+        addRecord(Capture::Direction::PortName, id, current_.firstTimestampNs, utf8.constData(), utf8.size());
+    }
+}
+
+void CaptureWriter::addRecord(Capture::Direction direction, int port, qint64 timestampNs, const char *data, int size)
+{
+    QByteArray &raw = current_.raw;
+    put<qint64>(raw, timestampNs);
+    raw.append(char(direction));
+    raw.append(char(quint8(port)));
+    put<quint32>(raw, quint32(size));
+    raw.append(data, size);
+    ++current_.records;
+    current_.lastTimestampNs = qMax(current_.lastTimestampNs, timestampNs);
+}
+
+void CaptureWriter::sealBlock()
+{
+    if (!blockOpen_)
+        return;
+    queue_.push_back(std::move(current_));
+    current_ = Block();
+    blockOpen_ = false;
+    wake_.wakeAll();
+}
+
+void CaptureWriter::run()
+{
+    bool done = false;
+    while (!done) {
+        Block block;
+        bool haveBlock = false;
+        {
+            QMutexLocker lock(&mutex_);
+            if (queue_.empty() && !stop_)
+                wake_.wait(&mutex_, QDeadlineTimer(200));
+            if (blockOpen_ && monotonicMs() >= current_.sealAtMs)
+                sealBlock();
+            if (!queue_.empty()) {
+                block = std::move(queue_.front());
+                queue_.pop_front();
+                haveBlock = true;
+            }
+            done = stop_ && queue_.empty() && !haveBlock;
+        }
+        // Compress and write outside the lock; append() carries on meanwhile
+        if (haveBlock)
+            writeBlock(block);
+    }
+}
+
+void CaptureWriter::writeBlock(const Block &block)
+{
+    const QByteArray packed = qCompress(block.raw, level_);
+    Capture::BlockInfo info;
+    info.fileOffset = file_.pos();
+    info.compressedSize = quint32(packed.size());
+    info.rawSize = quint32(block.raw.size());
+    info.records = block.records;
+    info.payloadSize = block.payloadSize;
+    info.firstTimestampNs = block.firstTimestampNs;
+    info.lastTimestampNs = block.lastTimestampNs;
+    info.firstByte = block.firstByte;
+
+    QByteArray out(kBlockMagic, sizeof(kBlockMagic));
+    out.reserve(kBlockHeaderSize + packed.size());
+    putBlockFields(out, info);
+    out.append(packed);
+    if (file_.write(out) != out.size()) {
+        QMutexLocker lock(&mutex_);
+        error_ = file_.errorString();
+        bytesDropped_.fetch_add(quint64(block.raw.size()), std::memory_order_relaxed);
+        // Keep later blocks where the index says they are
+        file_.seek(info.fileOffset);
+        return;
+    }
+    index_.push_back(info);
+    bytesWritten_.fetch_add(quint64(out.size()), std::memory_order_relaxed);
+}
+
+void CaptureWriter::writeIndex()
+{
+    const qint64 indexOffset = file_.pos();
+    QByteArray out(kIndexMagic, sizeof(kIndexMagic));
+    put<quint32>(out, quint32(index_.size()));
+    for (const Capture::BlockInfo &b : index_) {
+        put<quint64>(out, quint64(b.fileOffset));
+        putBlockFields(out, b);
+    }
+    put<quint64>(out, quint64(indexOffset));
+    out.append(kEndMagic, sizeof(kEndMagic));
+    if (file_.write(out) != out.size()) {
+        QMutexLocker lock(&mutex_);
+        error_ = file_.errorString();
+    }
+}
+
+QString CaptureWriter::errorString() const
+{
+    QMutexLocker lock(&mutex_);
+    return error_;
+}
+
+bool CaptureReader::isCapture(const QString &path)
+{
+    QFile f(path);
+    if (!f.open(QIODevice::ReadOnly))
+        return false;
+    const QByteArray magic = f.read(sizeof(kFileMagic));
+    return magic == QByteArray(kFileMagic, sizeof(kFileMagic));
+}
+
+bool CaptureReader::open(const QString &path)
+{
+    close();
+    file_.setFileName(path);
+    if (!file_.open(QIODevice::ReadOnly)) {
+        error_ = file_.errorString();
+        return false;
+    }
+    const QByteArray header = file_.read(kFileHeaderSize);
+    if (header.size() != kFileHeaderSize || !header.startsWith(QByteArray(kFileMagic, sizeof(kFileMagic)))) {
+        error_ = QString("%1 is not a capture file").arg(path);
+        file_.close();
+        return false;
+    }
+    if (get<quint32>(header.constData() + 8) > kVersion) {
+        error_ = QString("%1 was written by a newer version").arg(path);
+        file_.close();
+        return false;
+    }
+    startWallMs_ = get<qint64>(header.constData() + 12);
+    startMonotonicNs_ = get<qint64>(header.constData() + 20);
+    if (!readIndex())
+        scanBlocks();
+    return true;
+}
+
+void CaptureReader::close()
+{
+    file_.close();
+    error_.clear();
+    index_.clear();
+    portNames_.clear();
+    startWallMs_ = startMonotonicNs_ = 0;
+}
+
+bool CaptureReader::readIndex()
+{
+    const qint64 size = file_.size();
+    if (size < kFileHeaderSize + kTrailerSize || !file_.seek(size - kTrailerSize))
+        return false;
+    const QByteArray trailer = file_.read(kTrailerSize);
+    if (trailer.size() != kTrailerSize || !trailer.endsWith(QByteArray(kEndMagic, sizeof(kEndMagic))))
+        return false;
+    const qint64 indexOffset = qint64(get<quint64>(trailer.constData()));
+    if (indexOffset < kFileHeaderSize || indexOffset > size - kTrailerSize - 8 || !file_.seek(indexOffset))
+        return false;
+    const QByteArray head = file_.read(8);
+    if (head.size() != 8 || !head.startsWith(QByteArray(kIndexMagic, sizeof(kIndexMagic))))
+        return false;
+    const quint32 count = get<quint32>(head.constData() + 4);
+    if (qint64(count) * kIndexEntrySize != size - kTrailerSize - indexOffset - 8)
+        return false;
+    const QByteArray entries = file_.read(qint64(count) * kIndexEntrySize);
+    if (entries.size() != int(count) * kIndexEntrySize)
+        return false;
+    index_.resize(count);
+    for (quint32 i = 0; i < count; ++i) {
+        const char *p = entries.constData() + i * kIndexEntrySize;
+        index_[i].fileOffset = qint64(get<quint64>(p));
+        getBlockFields(p + 8, index_[i]);
+    }
+    return true;
+}
+
+void CaptureReader::scanBlocks()
+{
+    // No index: the writer stopped early. Walk the headers up to the first
+    // block that is not all there.
+    index_.clear();
+    const qint64 size = file_.size();
+    qint64 pos = kFileHeaderSize;
+    while (pos + kBlockHeaderSize <= size && file_.seek(pos)) {
+        const QByteArray head = file_.read(kBlockHeaderSize);
+        if (head.size() != kBlockHeaderSize || !head.startsWith(QByteArray(kBlockMagic, sizeof(kBlockMagic))))
+            break;
+        Capture::BlockInfo b;
+        b.fileOffset = pos;
+        getBlockFields(head.constData() + 4, b);
+        const qint64 next = pos + kBlockHeaderSize + qint64(b.compressedSize);
+        if (next > size)
+            break;
+        index_.push_back(b);
+        pos = next;
+    }
+}
+
+bool CaptureReader::readBlock(int i, QVector<Capture::Record> &out)
+{
+    out.clear();
+    if (i < 0 || i >= blockCount())
+        return false;
+    const Capture::BlockInfo &b = index_[size_t(i)];
+    if (!file_.seek(b.fileOffset + kBlockHeaderSize))
+        return false;
+    const QByteArray packed = file_.read(b.compressedSize);
+    if (packed.size() != int(b.compressedSize))
+        return false;
+    const QByteArray raw = qUncompress(packed);
+    if (raw.size() != int(b.rawSize))
+        return false;
+
+    out.reserve(int(b.records));
+    const char *p = raw.constData();
+    const char *end = p + raw.size();
+    while (end - p >= kRecordHeaderSize) {
+        Capture::Record r;
+        r.timestampNs = get<qint64>(p);
+        r.direction = Capture::Direction(quint8(p[8]));
+        r.port = quint8(p[9]);
+        const quint32 size = get<quint32>(p + 10);
+        p += kRecordHeaderSize;
+        if (quint64(end - p) < size)
+            return false;
+        r.data = QByteArray(p, int(size));
+        p += size;
+        if (r.direction == Capture::Direction::PortName) {
+            while (portNames_.size() <= r.port)
+                portNames_.append(QString());
+            portNames_[r.port] = QString::fromUtf8(r.data);
+        }
+        out.append(r);
+    }
+    return p == end;
+}
+
+int CaptureReader::blockForTime(qint64 timestampNs) const
+{
+    auto it = std::lower_bound(index_.begin(), index_.end(), timestampNs,
+                               [](const Capture::BlockInfo &b, qint64 t) { return b.lastTimestampNs < t; });
+    return int(it - index_.begin());
+}
+
+int CaptureReader::blockForByte(quint64 offset) const
+{
+    auto it = std::upper_bound(index_.begin(), index_.end(), offset,
+                               [](quint64 o, const Capture::BlockInfo &b) { return o < b.firstByte; });
+    if (it == index_.begin() || offset >= payloadBytes())
+        return blockCount();
+    return int(it - index_.begin()) - 1;
+}
+
+quint64 CaptureReader::payloadBytes() const
+{
+    if (index_.empty())
+        return 0;
+    return index_.back().firstByte + index_.back().payloadSize;
+}
@@ -0,0 +1,172 @@
+#include "capture_replay.h"
+#include "serial_worker.h"
+#include <QTimer>
+#include <cstring>
+
+CaptureReplay::CaptureReplay(QObject *parent)
+    : QObject(parent)
+{
+    timer_ = new QTimer(this);
+    timer_->setTimerType(Qt::PreciseTimer);
+    connect(timer_, &QTimer::timeout, this, &CaptureReplay::tick);
+}
+
+bool CaptureReplay::start(const QString &path, double speed, SeekBy by, qint64 offset)
+{
+    stop();
+    if (!reader_.open(path)) {
+        error_ = reader_.errorString();
+        return false;
+    }
+    if (reader_.blockCount() == 0) {
+        error_ = QString("%1 holds no data").arg(path);
+        reader_.close();
+        return false;
+    }
+
+    // Only the block holding the start point is inflated
+    offset = qMax<qint64>(0, offset);
+    const qint64 startTimeNs = reader_.block(0).firstTimestampNs + offset;
+    const int seekBlock = by == SeekBy::Time ? reader_.blockForTime(startTimeNs) : reader_.blockForByte(quint64(offset));
+    if (seekBlock >= reader_.blockCount()) {
+        error_ = QString("%1 ends before the start point").arg(path);
+        reader_.close();
+        return false;
+    }
+
+    path_ = path;
+    error_.clear();
+    speed_ = qMax(0.0, speed);
+    nextBlock_ = seekBlock;
+    records_.clear();
+    nextRecord_ = 0;
+    decodeNs_ = 0;
+    bytes_ = 0;
+    quint64 byte = reader_.block(seekBlock).firstByte;
+    total_ = reader_.payloadBytes() - byte;
+    damaged_ = 0;
+    loadNextBlock();
+    // Skip the records of the block before the start point; not if it was
+    // damaged and a later block was read instead
+    while (nextBlock_ == seekBlock + 1 && nextRecord_ < records_.size()) {
+        const Capture::Record &r = records_[nextRecord_];
+        const quint64 size = r.direction == Capture::Direction::PortName ? 0 : quint64(r.data.size());
+        if (by == SeekBy::Time ? r.timestampNs >= startTimeNs : byte + size > quint64(offset))
+            break;
+        byte += size;
+        total_ -= size;
+        ++nextRecord_;
+    }
+    firstTimestampNs_ = nextRecord_ < records_.size() ? records_[nextRecord_].timestampNs
+                                                      : reader_.block(seekBlock).firstTimestampNs;
+    startNs_ = SerialWorker::monotonicNs();
+    endNs_ = 0;
+    // At full speed the timer only hands control back to the event loop
+    timer_->start(speed_ > 0 ? kTickMs : 0);
+    return true;
+}
+
+void CaptureReplay::stop()
+{
+    if (isRunning())
+        finish(true);
+}
+
+bool CaptureReplay::isRunning() const
+{
+    return timer_->isActive();
+}
+
+qint64 CaptureReplay::elapsedNs() const
+{
+    if (startNs_ == 0)
+        return 0;
+    return (endNs_ ? endNs_ : SerialWorker::monotonicNs()) - startNs_;
+}
+
+double CaptureReplay::pipelineRate() const
+{
+    const qint64 ns = elapsedNs() - decodeNs_;
+    return ns > 0 ? double(bytes_) * 1e9 / double(ns) : 0.0;
+}
+
+void CaptureReplay::tick()
+{
+    // Paced replay that falls behind catches up a slice at a time, so the
+    // window keeps painting either way
+    const qint64 sliceEnd = SerialWorker::monotonicNs() + qint64(kSliceMs) * 1000000;
+    for (;;) {
+        if (nextRecord_ >= records_.size()) {
+            if (!loadNextBlock()) {
+                finish(false);
+                return;
+            }
+            continue;
+        }
+        const qint64 now = SerialWorker::monotonicNs();
+        if (now >= sliceEnd)
+            return;
+        // A copy (sharing the bytes): a slot may stop the replay and drop records_
+        const Capture::Record record = records_[nextRecord_];
+        qint64 at = now;
+        if (speed_ > 0) {
+            at = startNs_ + qint64(double(record.timestampNs - firstTimestampNs_) / speed_);
+            if (at > now)
+                return;
+        }
+        ++nextRecord_;
+        emitRecord(record, at);
+        if (!isRunning())
+            return;
+    }
+}
+
+bool CaptureReplay::loadNextBlock()
+{
+    const qint64 t0 = SerialWorker::monotonicNs();
+    records_.clear();
+    nextRecord_ = 0;
+    while (records_.isEmpty() && nextBlock_ < reader_.blockCount()) {
+        if (!reader_.readBlock(nextBlock_++, records_))
+            ++damaged_;
+    }
+    decodeNs_ += SerialWorker::monotonicNs() - t0;
+    return !records_.isEmpty();
+}
+
+void CaptureReplay::emitRecord(const Capture::Record &record, qint64 atNs)
+{
+    if (record.direction == Capture::Direction::PortName)
+        return;
+    const QString port = reader_.portNames().value(record.port);
+    bytes_ += quint64(record.data.size());
+    if (record.direction == Capture::Direction::Tx) {
+        emit dataSent(port, record.data);
+        return;
+    }
+
+    // Same pooled chunks the workers hand out; a record is one read, so it
+    // normally fits one block
+    RxBufferPool &pool = RxBufferPool::instance();
+    const char *p = record.data.constData();
+    int left = record.data.size();
+    while (left > 0) {
+        const int len = qMin(left, int(RxBlock::kSize));
+        RxBlock *block = pool.acquire();
+        memcpy(block->data, p, size_t(len));
+        emit dataReceived(port, pool.wrap(block, len, atNs));
+        if (!isRunning())
+            return;
+        p += len;
+        left -= len;
+    }
+}
+
+void CaptureReplay::finish(bool stopped)
+{
+    timer_->stop();
+    endNs_ = SerialWorker::monotonicNs();
+    records_.clear();
+    reader_.close();
+    emit finished(stopped);
+}
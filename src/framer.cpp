@@ -0,0 +1,340 @@
+#include "framer.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+// Frames end at one of up to two delimiter bytes, delimiter included.
+class DelimiterFramer : public Framer
+{
+public:
+    DelimiterFramer(char a, char b) : a_(a), b_(b) {}
+
+    void feed(const char *data, int size, const FrameHandler &onFrame) override
+    {
+        const char *p = data;
+        const char *end = data + size;
+        // Next occurrence of each delimiter; each is searched for only after
+        // the read offset has passed the previous hit.
+        const char *nextA = nullptr;
+        const char *nextB = nullptr;
+        while (p < end) {
+            if (!nextA || nextA < p)
+                nextA = find(p, end, a_);
+            if (a_ == b_)
+                nextB = nextA;
+            else if (!nextB || nextB < p)
+                nextB = find(p, end, b_);
+            const char *hit = std::min(nextA, nextB);
+            if (hit == end)
+                break;
+
+            const char *frameEnd = hit + 1;
+            emitFrame(p, int(frameEnd - p), uchar(*hit), onFrame);
+            p = frameEnd;
+        }
+        carry(p, int(end - p), onFrame);
+    }
+
+    void reset() override { pending_.clear(); }
+    int pendingSize() const override { return pending_.size(); }
+
+protected:
+    static const char *find(const char *p, const char *end, char c)
+    {
+        const void *hit = memchr(p, c, size_t(end - p));
+        return hit ? static_cast<const char *>(hit) : end;
+    }
+
+    void emitFrame(const char *p, int len, int delimiter, const FrameHandler &onFrame)
+    {
+        if (pending_.isEmpty()) {
+            onFrame({p, len, delimiter});
+            return;
+        }
+        pending_.append(p, len);
+        onFrame({pending_.constData(), pending_.size(), delimiter});
+        pending_.resize(0);
+    }
+
+    void carry(const char *p, int len, const FrameHandler &onFrame)
+    {
+        if (len <= 0)
+            return;
+        if (pending_.capacity() == 0)
+            pending_.reserve(4096);
+        pending_.append(p, len);
+        if (pending_.size() >= kMaxFrameSize) {
+            onFrame({pending_.constData(), pending_.size(), -1});
+            pending_.resize(0);
+        }
+    }
+
+    QByteArray pending_;    // incomplete frame from earlier chunks
+
+private:
+    char a_;
+    char b_;
+};
+
+// Frames end at "\r\n"; a bare '\n' is ordinary data.
+class CrLfFramer : public DelimiterFramer
+{
+public:
+    CrLfFramer() : DelimiterFramer('\n', '\n') {}
+
+    void feed(const char *data, int size, const FrameHandler &onFrame) override
+    {
+        const char *p = data;
+        const char *end = data + size;
+        const char *scan = p;
+        while (scan < end) {
+            const char *lf = find(scan, end, '\n');
+            if (lf == end)
+                break;
+            // The '\r' may be the last byte carried over from the previous chunk
+            const bool cr = lf > p ? lf[-1] == '\r'
+                                   : (!pending_.isEmpty() && pending_.endsWith('\r'));
+            scan = lf + 1;
+            if (!cr)
+                continue;
+            emitFrame(p, int(scan - p), '\n', onFrame);
+            p = scan;
+        }
+        carry(p, int(end - p), onFrame);
+    }
+};
+
+// RFC 1055 SLIP: frames separated by END, with ESC sequences for END/ESC in
+// the payload. Frames without escapes are passed as views of the chunk.
+class SlipFramer : public Framer
+{
+public:
+    void feed(const char *data, int size, const FrameHandler &onFrame) override
+    {
+        const char *p = data;
+        const char *end = data + size;
+        while (p < end) {
+            if (escaped_) {
+                escaped_ = false;
+                out_.append(unescape(*p++));
+                continue;
+            }
+            const char *e = static_cast<const char *>(memchr(p, kEnd, size_t(end - p)));
+            const char *stop = e ? e : end;
+
+            if (e && out_.isEmpty() && !memchr(p, kEsc, size_t(stop - p))) {
+                // Whole frame inside this chunk and nothing to unescape
+                if (stop > p)
+                    onFrame({p, int(stop - p), -1});
+                p = e + 1;
+                continue;
+            }
+
+            while (p < stop) {
+                const char *esc = static_cast<const char *>(memchr(p, kEsc, size_t(stop - p)));
+                const char *runEnd = esc ? esc : stop;
+                out_.append(p, int(runEnd - p));
+                p = runEnd;
+                if (!esc)
+                    break;
+                ++p;
+                if (p < stop)
+                    out_.append(unescape(*p++));
+                else
+                    escaped_ = true;
+            }
+            if (!e) {
+                if (out_.size() >= kMaxFrameSize) {
+                    onFrame({out_.constData(), out_.size(), -1});
+                    out_.resize(0);
+                }
+                break;
+            }
+            // ESC directly before END is a protocol error; drop the ESC
+            escaped_ = false;
+            if (!out_.isEmpty())
+                onFrame({out_.constData(), out_.size(), -1});
+            out_.resize(0);
+            p = e + 1;
+        }
+    }
+
+    void reset() override
+    {
+        out_.clear();
+        escaped_ = false;
+    }
+
+    int pendingSize() const override { return out_.size(); }
+
+private:
+    static const char kEnd = char(0xC0);
+    static const char kEsc = char(0xDB);
+
+    static char unescape(char c)
+    {
+        if (c == char(0xDC))
+            return kEnd;
+        if (c == char(0xDD))
+            return kEsc;
+        return c;
+    }
+
+    QByteArray out_;
+    bool escaped_ = false;
+};
+
+// COBS: each 0x00 ends an encoded frame, which is decoded into out_.
+class CobsFramer : public Framer
+{
+public:
+    void feed(const char *data, int size, const FrameHandler &onFrame) override
+    {
+        const char *p = data;
+        const char *end = data + size;
+        while (p < end) {
+            const char *zero = static_cast<const char *>(memchr(p, 0, size_t(end - p)));
+            if (!zero) {
+                pending_.append(p, int(end - p));
+                if (pending_.size() >= kMaxFrameSize)
+                    pending_.resize(0);    // cannot be valid COBS any more
+                break;
+            }
+            if (pending_.isEmpty()) {
+                decode(p, int(zero - p), onFrame);
+            } else {
+                pending_.append(p, int(zero - p));
+                decode(pending_.constData(), pending_.size(), onFrame);
+                pending_.resize(0);
+            }
+            p = zero + 1;
+        }
+    }
+
+    void reset() override
+    {
+        pending_.clear();
+        out_.clear();
+    }
+
+    int pendingSize() const override { return pending_.size(); }
+
+private:
+    void decode(const char *in, int n, const FrameHandler &onFrame)
+    {
+        if (n == 0)
+            return;
+        out_.resize(0);
+        int i = 0;
+        while (i < n) {
+            const int code = uchar(in[i++]);
+            const int run = code - 1;
+            if (run > n - i)
+                return;    // truncated block: drop the frame
+            out_.append(in + i, run);
+            i += run;
+            if (code != 0xFF && i < n)
+                out_.append('\0');
+        }
+        if (!out_.isEmpty())
+            onFrame({out_.constData(), out_.size(), -1});
+    }
+
+    QByteArray pending_;    // encoded bytes of an incomplete frame
+    QByteArray out_;        // decoded frame
+};
+
+// 16-bit big-endian payload length followed by the payload.
+class LengthPrefixedFramer : public Framer
+{
+public:
+    void feed(const char *data, int size, const FrameHandler &onFrame) override
+    {
+        const char *p = data;
+        const char *end = data + size;
+        while (p < end) {
+            if (pending_.isEmpty()) {
+                // Fast path: header and payload both inside the chunk
+                if (end - p >= 2) {
+                    const int len = payloadLength(p);
+                    if (end - p >= 2 + len) {
+                        onFrame({p + 2, len, -1});
+                        p += 2 + len;
+                        continue;
+                    }
+                }
+                pending_.append(p, int(end - p));
+                break;
+            }
+
+            const int need = pending_.size() < 2 ? 2 - pending_.size()
+                                                 : 2 + payloadLength(pending_.constData()) - pending_.size();
+            const int take = int(std::min<qint64>(need, end - p));
+            pending_.append(p, take);
+            p += take;
+            if (pending_.size() >= 2 && pending_.size() == 2 + payloadLength(pending_.constData())) {
+                onFrame({pending_.constData() + 2, pending_.size() - 2, -1});
+                pending_.resize(0);
+            }
+        }
+    }
+
+    void reset() override { pending_.clear(); }
+    // The length header is not part of the frame
+    int pendingSize() const override { return qMax(0, pending_.size() - 2); }
+
+private:
+    static int payloadLength(const char *header)
+    {
+        return (int(uchar(header[0])) << 8) | int(uchar(header[1]));
+    }
+
+    QByteArray pending_;
+};
+
+} // namespace
+
+Framer *Framer::create(Kind kind)
+{
+    switch (kind) {
+    case Kind::Lf:
+        return new DelimiterFramer('\n', '\n');
+    case Kind::CrLf:
+        return new CrLfFramer();
+    case Kind::Etx:
+        return new DelimiterFramer(char(0xDD), char(0xDD));
+    case Kind::Slip:
+        return new SlipFramer();
+    case Kind::Cobs:
+        return new CobsFramer();
+    case Kind::LengthPrefixed:
+        return new LengthPrefixedFramer();
+    case Kind::LineOrEtx:
+    default:
+        return new DelimiterFramer('\n', char(0xDD));
+    }
+}
+
+QString Framer::kindName(Kind kind)
+{
+    switch (kind) {
+    case Kind::Lf: return "LF";
+    case Kind::CrLf: return "CRLF";
+    case Kind::Etx: return "ETX";
+    case Kind::Slip: return "SLIP";
+    case Kind::Cobs: return "COBS";
+    case Kind::LengthPrefixed: return "LEN16";
+    case Kind::LineOrEtx:
+    default: return "LF_ETX";
+    }
+}
+
+Framer::Kind Framer::kindFromName(const QString &name)
+{
+    for (Kind k : {Kind::Lf, Kind::CrLf, Kind::Etx, Kind::Slip, Kind::Cobs, Kind::LengthPrefixed}) {
+        if (name == kindName(k))
+            return k;
+    }
+    return Kind::LineOrEtx;
+}
@@ -7,36 +7,28 @@
 #include <QCheckBox>
 #include <QColorDialog>
 #include <QSettings>
+#include <QScrollArea>
 
 HighlightRulesDialog::HighlightRulesDialog(QWidget *parent)
     : QDialog(parent)
 {
     setWindowTitle(tr("Highlight rules"));
     setModal(true);
+    resize(560, 360);
     QVBoxLayout *v = new QVBoxLayout(this);
 
-    for (int i = 0; i < kMaxRules; ++i) {
-        QWidget *row = new QWidget(this);
-        QHBoxLayout *h = new QHBoxLayout(row);
-        h->setContentsMargins(0, 0, 0, 0);
-        QLabel *lbl = new QLabel(tr("Pattern:"), this);
-        patternEdits[i] = new QLineEdit(this);
-        patternEdits[i]->setMaxLength(64);
-        colorButtons[i] = new QPushButton(this);
-        colorButtons[i]->setFixedWidth(36);
-        enableChecks[i] = new QCheckBox(tr("Enable"), this);
-        enableChecks[i]->setChecked(true);
-
-        h->addWidget(lbl);
-        h->addWidget(patternEdits[i], 1);
-        h->addWidget(colorButtons[i]);
-        h->addWidget(enableChecks[i]);
-        v->addWidget(row);
-
-        connect(colorButtons[i], &QPushButton::clicked, this, [this, i]() { chooseColor(i); });
-    }
+    // Rules are compiled into one automaton, so the list can be long
+    QScrollArea *scroll = new QScrollArea(this);
+    scroll->setWidgetResizable(true);
+    QWidget *rowsWidget = new QWidget(scroll);
+    rowsLayout_ = new QVBoxLayout(rowsWidget);
+    rowsLayout_->addStretch();
+    scroll->setWidget(rowsWidget);
+    v->addWidget(scroll, 1);
 
     QHBoxLayout *btns = new QHBoxLayout();
+    addBtn_ = new QPushButton(tr("Add rule"), this);
+    btns->addWidget(addBtn_);
     btns->addStretch();
     QPushButton *ok = new QPushButton(tr("OK"), this);
     QPushButton *cancel = new QPushButton(tr("Cancel"), this);
@@ -44,20 +36,79 @@ HighlightRulesDialog::HighlightRulesDialog(QWidget *parent)
     btns->addWidget(cancel);
     v->addLayout(btns);
 
+    connect(addBtn_, &QPushButton::clicked, this, [this, scroll]() {
+        HighlightRule r;
+        r.color = QColor("#FFFF00");
+        addRow(r);
+        rows_.last().patternEdit->setFocus();
+        scroll->ensureWidgetVisible(rows_.last().row);
+    });
     connect(ok, &QPushButton::clicked, this, &HighlightRulesDialog::accept);
     connect(cancel, &QPushButton::clicked, this, &HighlightRulesDialog::reject);
 
     loadFromSettings();
 }
 
+void HighlightRulesDialog::addRow(const HighlightRule &rule)
+{
+    if (rows_.size() >= kMaxRules)
+        return;
+    RuleRow r;
+    r.row = new QWidget(this);
+    QHBoxLayout *h = new QHBoxLayout(r.row);
+    h->setContentsMargins(0, 0, 0, 0);
+    QLabel *lbl = new QLabel(tr("Pattern:"), r.row);
+    r.patternEdit = new QLineEdit(rule.pattern, r.row);
+    r.patternEdit->setMaxLength(64);
+    r.colorButton = new QPushButton(r.row);
+    r.colorButton->setFixedWidth(36);
+    r.colorButton->setStyleSheet(QString("background-color: %1;").arg(rule.color.name()));
+    r.color = rule.color;
+    r.enableCheck = new QCheckBox(tr("Enable"), r.row);
+    r.enableCheck->setChecked(rule.enabled);
+    QPushButton *removeBtn = new QPushButton(tr("Remove"), r.row);
+
+    h->addWidget(lbl);
+    h->addWidget(r.patternEdit, 1);
+    h->addWidget(r.colorButton);
+    h->addWidget(r.enableCheck);
+    h->addWidget(removeBtn);
+    // Keep the stretch at the bottom
+    rowsLayout_->insertWidget(rowsLayout_->count() - 1, r.row);
+
+    QWidget *row = r.row;
+    connect(r.colorButton, &QPushButton::clicked, this, [this, row]() {
+        for (int i = 0; i < rows_.size(); ++i) {
+            if (rows_[i].row == row)
+                chooseColor(i);
+        }
+    });
+    connect(removeBtn, &QPushButton::clicked, this, [this, row]() { removeRow(row); });
+
+    rows_.append(r);
+    addBtn_->setEnabled(rows_.size() < kMaxRules);
+}
+
+void HighlightRulesDialog::removeRow(QWidget *row)
+{
+    for (int i = 0; i < rows_.size(); ++i) {
+        if (rows_[i].row == row) {
+            rows_.remove(i);
+            break;
+        }
+    }
+    row->deleteLater();
+    addBtn_->setEnabled(rows_.size() < kMaxRules);
+}
+
 QVector<HighlightRule> HighlightRulesDialog::rules() const
 {
     QVector<HighlightRule> out;
-    for (int i = 0; i < kMaxRules; ++i) {
+    for (const RuleRow &row : rows_) {
         HighlightRule r;
-        r.pattern = patternEdits[i]->text().trimmed();
-        r.color = colorButtons[i]->palette().button().color();
-        r.enabled = enableChecks[i]->isChecked();
+        r.pattern = row.patternEdit->text().trimmed();
+        r.color = row.color;
+        r.enabled = row.enableCheck->isChecked();
         if (!r.pattern.isEmpty())
             out.append(r);
     }
@@ -66,11 +117,12 @@ QVector<HighlightRule> HighlightRulesDialog::rules() const
 
 void HighlightRulesDialog::chooseColor(int index)
 {
-    QColor current = colorButtons[index]->palette().button().color();
+    QColor current = rows_[index].color;
     QColor c = QColorDialog::getColor(current, this, tr("Choose color"));
     if (!c.isValid())
         return;
-    colorButtons[index]->setStyleSheet(QString("background-color: %1;").arg(c.name()));
+    rows_[index].color = c;
+    rows_[index].colorButton->setStyleSheet(QString("background-color: %1;").arg(c.name()));
 }
 
 void HighlightRulesDialog::accept()
@@ -86,23 +138,25 @@ void HighlightRulesDialog::loadFromSettings()
     QSettings s;
     s.beginGroup("HighlightRules");
     int count = s.value("Count", 0).toInt();
-    for (int i = 0; i < kMaxRules; ++i) {
-        if (i < count) {
-            s.beginGroup(QString::number(i));
-            QString pat = s.value("pattern", "").toString();
-            QString col = s.value("color", "#FFFF00").toString();
-            bool en = s.value("enabled", true).toBool();
-            s.endGroup();
-            patternEdits[i]->setText(pat);
-            colorButtons[i]->setStyleSheet(QString("background-color: %1;").arg(col));
-            enableChecks[i]->setChecked(en);
-        } else {
-            patternEdits[i]->clear();
-            colorButtons[i]->setStyleSheet("background-color: #FFFF00;");
-            enableChecks[i]->setChecked(false);
-        }
+    if (count > kMaxRules)
+        count = kMaxRules;
+    for (int i = 0; i < count; ++i) {
+        s.beginGroup(QString::number(i));
+        HighlightRule r;
+        r.pattern = s.value("pattern", "").toString();
+        r.color = QColor(s.value("color", "#FFFF00").toString());
+        r.enabled = s.value("enabled", true).toBool();
+        s.endGroup();
+        addRow(r);
     }
     s.endGroup();
+    // Empty, disabled slots to fill in
+    while (rows_.size() < kMinRows) {
+        HighlightRule r;
+        r.color = QColor("#FFFF00");
+        r.enabled = false;
+        addRow(r);
+    }
 }
 
 void HighlightRulesDialog::saveToSettings(const QVector<HighlightRule> &r)
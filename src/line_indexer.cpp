@@ -0,0 +1,124 @@
+#include "line_indexer.h"
+#include "log_line_store.h"
+#include <QRunnable>
+#include <atomic>
+#include <cstring>
+#include <functional>
+
+struct LineIndexer::State
+{
+    std::shared_ptr<const void> owner;
+    const char *data = nullptr;
+    qint64 size = 0;
+    std::atomic<bool> cancelled{false};
+};
+
+namespace {
+
+// Longest piece cut without a '\n'; a longer line is shown broken up
+const qint64 kMaxPiece = qint64(1) << 30;
+
+class IndexTask : public QRunnable
+{
+public:
+    using Post = std::function<void(int, std::vector<quint32> &, bool)>;
+
+    IndexTask(std::shared_ptr<LineIndexer::State> state, Post post)
+        : state_(std::move(state)), post_(std::move(post))
+    {
+    }
+
+    void run() override;
+
+private:
+    std::shared_ptr<LineIndexer::State> state_;
+    Post post_;
+};
+
+} // namespace
+
+void IndexTask::run()
+{
+    const char *p = state_->data;
+    const char *end = p + state_->size;
+    while (p < end && !state_->cancelled.load()) {
+        // Cut after the last '\n' of a chunk-sized piece, or after the first
+        // one beyond it if the piece is a single line
+        const char *limit = p + qMin<qint64>(end - p, LogLineStore::kChunkSize);
+        const char *cut = limit;
+        if (limit < end) {
+            while (cut > p && cut[-1] != '\n')
+                --cut;
+            if (cut == p) {
+                const char *nl = static_cast<const char *>(memchr(limit, '\n', size_t(qMin<qint64>(end - limit, kMaxPiece))));
+                cut = nl ? nl + 1 : limit + qMin<qint64>(end - limit, kMaxPiece);
+            }
+        }
+
+        std::vector<quint32> starts;
+        starts.reserve(size_t(cut - p) / 64);
+        starts.push_back(0);
+        for (const char *q = p; (q = static_cast<const char *>(memchr(q, '\n', size_t(cut - q)))) && ++q < cut;)
+            starts.push_back(quint32(q - p));
+        post_(int(cut - p), starts, cut == end);
+        p = cut;
+    }
+}
+
+LineIndexer::LineIndexer(QObject *parent)
+    : QObject(parent)
+{
+    // One sequential scan; the disk is the limit, not the CPU
+    pool_.setMaxThreadCount(1);
+}
+
+LineIndexer::~LineIndexer()
+{
+    // No cancelled(): the receivers may be going away as well
+    if (state_)
+        state_->cancelled.store(true);
+    pool_.waitForDone();
+}
+
+void LineIndexer::start(std::shared_ptr<const void> owner, const char *data, qint64 size)
+{
+    cancel();
+    if (!data || size <= 0) {
+        emit finished();
+        return;
+    }
+
+    auto state = std::make_shared<State>();
+    state->owner = std::move(owner);
+    state->data = data;
+    state->size = size;
+    state_ = state;
+
+    auto post = [this, state](int pieceSize, std::vector<quint32> &starts, bool last) {
+        QMetaObject::invokeMethod(
+            this, [this, state, pieceSize, starts = std::move(starts), last]() { pieceDone(state, pieceSize, starts, last); },
+            Qt::QueuedConnection);
+    };
+    pool_.start(new IndexTask(state, post));
+}
+
+void LineIndexer::cancel()
+{
+    if (!state_)
+        return;
+    state_->cancelled.store(true);
+    state_.reset();
+    emit cancelled();
+}
+
+void LineIndexer::pieceDone(const std::shared_ptr<State> &state, int size, const std::vector<quint32> &starts,
+                            bool last)
+{
+    if (state != state_)
+        return;     // from a cancelled scan
+    emit pieceIndexed(size, starts);
+    if (last && state == state_) {
+        state_.reset();
+        emit finished();
+    }
+}
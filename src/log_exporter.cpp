@@ -0,0 +1,143 @@
+#include "log_exporter.h"
+#include "log_line_store.h"
+#include <QFile>
+#include <QRunnable>
+#include <QSaveFile>
+#include <atomic>
+#include <functional>
+
+struct LogExporter::State
+{
+    LogLineStore::Snapshot snapshot;
+    // Opened by start(): clearing the store removes the spill file
+    std::unique_ptr<QFile> spill;
+    QString path;
+    qint64 total = 0;
+    std::atomic<bool> cancelled{false};
+};
+
+namespace {
+
+class ExportTask : public QRunnable
+{
+public:
+    using Progress = std::function<void(qint64)>;
+    using Done = std::function<void(const QString &)>;
+
+    ExportTask(std::shared_ptr<LogExporter::State> state, Progress progress, Done done)
+        : state_(std::move(state)), progress_(std::move(progress)), done_(std::move(done))
+    {
+    }
+
+    void run() override;
+
+private:
+    std::shared_ptr<LogExporter::State> state_;
+    Progress progress_;
+    Done done_;
+};
+
+} // namespace
+
+void ExportTask::run()
+{
+    QSaveFile out(state_->path);
+    QString error;
+    if (!out.open(QIODevice::WriteOnly))
+        error = out.errorString();
+
+    qint64 done = 0;
+    for (LogLineStore::Snapshot::Block &block : state_->snapshot.blocks) {
+        if (!error.isEmpty() || state_->cancelled.load())
+            break;
+        // Taken out of the snapshot, so each chunk is released once written
+        QByteArray data;
+        data.swap(block.data);
+        if (data.isEmpty() && block.spillOffset >= 0) {
+            QFile *spill = state_->spill.get();
+            if (!spill || !spill->seek(block.spillOffset)
+                || (data = spill->read(block.spillSize)).size() != block.spillSize) {
+                error = QString("Cannot read the scrollback file: %1")
+                            .arg(spill ? spill->errorString() : state_->snapshot.spillPath);
+                break;
+            }
+        }
+        if (out.write(data) != data.size()) {
+            error = out.errorString();
+            break;
+        }
+        done += data.size();
+        progress_(done);
+    }
+
+    if (!error.isEmpty() || state_->cancelled.load())
+        out.cancelWriting();
+    else if (!out.commit())
+        error = out.errorString();
+    done_(error);
+}
+
+LogExporter::LogExporter(QObject *parent)
+    : QObject(parent)
+{
+    // One sequential write; the disk is the limit
+    pool_.setMaxThreadCount(1);
+}
+
+LogExporter::~LogExporter()
+{
+    cancel();
+    pool_.waitForDone();
+}
+
+bool LogExporter::start(const LogLineStore &store, const QString &path)
+{
+    if (isRunning())
+        return false;
+
+    auto state = std::make_shared<State>();
+    state->snapshot = store.snapshot();
+    state->path = path;
+    for (const LogLineStore::Snapshot::Block &block : state->snapshot.blocks)
+        state->total += block.data.isEmpty() ? block.spillSize : block.data.size();
+    if (!state->snapshot.spillPath.isEmpty()) {
+        state->spill.reset(new QFile(state->snapshot.spillPath));
+        if (!state->spill->open(QIODevice::ReadOnly))
+            state->spill.reset();
+    }
+    state_ = state;
+    path_ = path;
+
+    auto postProgress = [this, state](qint64 done) {
+        QMetaObject::invokeMethod(
+            this, [this, state, done]() {
+                if (state == state_)
+                    emit progress(done, state->total);
+            },
+            Qt::QueuedConnection);
+    };
+    auto postDone = [this, state](const QString &error) {
+        QMetaObject::invokeMethod(this, [this, state, error]() { taskDone(state, error); }, Qt::QueuedConnection);
+    };
+    pool_.start(new ExportTask(state, postProgress, postDone));
+    return true;
+}
+
+void LogExporter::cancel()
+{
+    if (state_)
+        state_->cancelled.store(true);
+}
+
+void LogExporter::waitForDone()
+{
+    pool_.waitForDone();
+}
+
+void LogExporter::taskDone(const std::shared_ptr<State> &state, const QString &error)
+{
+    if (state != state_)
+        return;
+    state_.reset();
+    emit finished(state->cancelled.load(), error);
+}
@@ -0,0 +1,240 @@
+#include "log_file_writer.h"
+
+#include <QDeadlineTimer>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QThread>
+
+#ifdef Q_OS_WIN
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+LogFileWriter::~LogFileWriter()
+{
+    stop();
+}
+
+bool LogFileWriter::start(const Settings &settings)
+{
+    if (isRunning())
+        return false;
+    if (!QDir().mkpath(settings.dir)) {
+        QMutexLocker lock(&mutex_);
+        error_ = QString("Cannot create %1").arg(settings.dir);
+        return false;
+    }
+
+    settings_ = settings;
+    {
+        QMutexLocker lock(&mutex_);
+        buffer_.clear();
+        buffer_.reserve(kBatchBytes);
+        stop_ = false;
+        rotate_ = false;
+        error_.clear();
+    }
+
+    thread_ = QThread::create([this]() { run(); });
+    thread_->setObjectName("LogFileWriter");
+    thread_->start(QThread::LowPriority);
+    return true;
+}
+
+void LogFileWriter::stop()
+{
+    if (!thread_)
+        return;
+    {
+        QMutexLocker lock(&mutex_);
+        stop_ = true;
+        wake_.wakeAll();
+    }
+    thread_->wait();
+    delete thread_;
+    thread_ = nullptr;
+}
+
+void LogFileWriter::append(const char *data, int size)
+{
+    if (size <= 0 || !thread_)
+        return;
+    QMutexLocker lock(&mutex_);
+    if (buffer_.size() + size > kMaxBufferBytes) {
+        dropped_.fetch_add(quint64(size), std::memory_order_relaxed);
+        return;
+    }
+    buffer_.append(data, size);
+    if (buffer_.size() >= kBatchBytes)
+        wake_.wakeAll();
+}
+
+void LogFileWriter::rotate()
+{
+    QMutexLocker lock(&mutex_);
+    rotate_ = true;
+    wake_.wakeAll();
+}
+
+QString LogFileWriter::currentFile() const
+{
+    QMutexLocker lock(&mutex_);
+    return currentFile_;
+}
+
+QString LogFileWriter::errorString() const
+{
+    QMutexLocker lock(&mutex_);
+    return error_;
+}
+
+void LogFileWriter::run()
+{
+    QElapsedTimer clock;
+    clock.start();
+    QByteArray batch;
+    batch.reserve(kBatchBytes);
+    bool done = false;
+    while (!done) {
+        bool rotateAfter;
+        {
+            QMutexLocker lock(&mutex_);
+            if (!stop_ && !rotate_ && buffer_.size() < kBatchBytes)
+                wake_.wait(&mutex_, QDeadlineTimer(settings_.batchIntervalMs));
+            // Swap buffers; append() carries on into the (empty) old batch
+            batch.swap(buffer_);
+            rotateAfter = rotate_;
+            rotate_ = false;
+            done = stop_;
+        }
+
+        if (!batch.isEmpty())
+            writeBatch(batch, rotateAfter);
+        else if (rotateAfter)
+            closeFile();
+        batch.resize(0);     // keeps the reserved capacity, unlike clear()
+
+        if (unsynced_ && settings_.sync == SyncPolicy::Interval
+            && clock.elapsed() - lastSyncMs_ >= settings_.syncIntervalMs) {
+            sync();
+            lastSyncMs_ = clock.elapsed();
+        }
+    }
+    closeFile();
+}
+
+void LogFileWriter::writeBatch(const QByteArray &batch, bool rotateAfter)
+{
+    // Rotation happens between batches, so a line may carry over to the next file
+    if (file_) {
+        const bool full = settings_.maxFileBytes > 0 && fileBytes_ >= settings_.maxFileBytes;
+        const bool old = settings_.maxFileMinutes > 0
+                         && fileOpened_.secsTo(QDateTime::currentDateTime()) >= qint64(settings_.maxFileMinutes) * 60;
+        if (full || old)
+            closeFile();
+    }
+    if (!file_ && !openNewFile()) {
+        dropped_.fetch_add(quint64(batch.size()), std::memory_order_relaxed);
+        return;
+    }
+
+    const qint64 w = file_->write(batch);
+    if (w != batch.size()) {
+        QMutexLocker lock(&mutex_);
+        error_ = file_->errorString();
+    }
+    if (w > 0) {
+        fileBytes_ += w;
+        written_.fetch_add(quint64(w), std::memory_order_relaxed);
+        unsynced_ = true;
+    }
+    if (w < batch.size())
+        dropped_.fetch_add(quint64(batch.size() - qMax<qint64>(w, 0)), std::memory_order_relaxed);
+
+    if (settings_.sync == SyncPolicy::EveryBatch)
+        sync();
+    if (rotateAfter)
+        closeFile();
+}
+
+bool LogFileWriter::openNewFile()
+{
+    const QDir dir(settings_.dir);
+    const QString stamp = QDateTime::currentDateTime().toString("yyMMdd_hhmmss");
+    QString path = dir.filePath(QString("stream_%1.txt").arg(stamp));
+    // Several rotations within one second
+    for (int n = 1; QFile::exists(path); ++n)
+        path = dir.filePath(QString("stream_%1_%2.txt").arg(stamp).arg(n));
+
+    // Batches are already large; no second buffer in QFile
+    QFile *file = new QFile(path);
+    if (!file->open(QIODevice::WriteOnly | QIODevice::Unbuffered)) {
+        QMutexLocker lock(&mutex_);
+        error_ = file->errorString();
+        delete file;
+        return false;
+    }
+    file_ = file;
+    fileBytes_ = 0;
+    fileOpened_ = QDateTime::currentDateTime();
+    {
+        QMutexLocker lock(&mutex_);
+        currentFile_ = path;
+    }
+    pruneOldFiles();
+    return true;
+}
+
+void LogFileWriter::pruneOldFiles()
+{
+    if (settings_.keepFiles <= 0 && settings_.keepBytes <= 0)
+        return;
+    // Newest first, and only files named as openNewFile() names them
+    const QFileInfoList files = QDir(settings_.dir).entryInfoList({"stream_*.txt"}, QDir::Files, QDir::Time);
+    const QString current = QFileInfo(file_->fileName()).absoluteFilePath();
+    // The current file counts as one, and as big as it may grow
+    int kept = 1;
+    qint64 keptBytes = settings_.maxFileBytes;
+    bool full = false;
+    for (const QFileInfo &info : files) {
+        if (info.absoluteFilePath() == current)
+            continue;
+        full = full || (settings_.keepFiles > 0 && kept >= settings_.keepFiles)
+               || (settings_.keepBytes > 0 && keptBytes + info.size() > settings_.keepBytes);
+        if (!full) {
+            ++kept;
+            keptBytes += info.size();
+        } else if (!QFile::remove(info.absoluteFilePath())) {
+            QMutexLocker lock(&mutex_);
+            error_ = QString("Cannot delete old log %1").arg(info.fileName());
+        }
+    }
+}
+
+void LogFileWriter::closeFile()
+{
+    if (!file_)
+        return;
+    if (settings_.sync != SyncPolicy::Never)
+        sync();
+    file_->close();
+    delete file_;
+    file_ = nullptr;
+    QMutexLocker lock(&mutex_);
+    currentFile_.clear();
+}
+
+void LogFileWriter::sync()
+{
+    if (!file_ || !unsynced_)
+        return;
+#ifdef Q_OS_WIN
+    _commit(file_->handle());
+#else
+    ::fsync(file_->handle());
+#endif
+    unsynced_ = false;
+}
@@ -1,8 +1,9 @@
 #include "log_highlighter.h"
 #include <QSettings>
+#include <algorithm>
 
-LogHighlighter::LogHighlighter(QTextDocument *parent)
-    : QSyntaxHighlighter(parent)
+LogHighlighter::LogHighlighter(QObject *parent)
+    : QObject(parent)
 {
     loadFromSettings();
 }
@@ -10,36 +11,125 @@ LogHighlighter::LogHighlighter(QTextDocument *parent)
 void LogHighlighter::setRules(const QVector<HighlightRule> &rules)
 {
     rules_ = rules;
-    rehighlight();
+    compile();
+    emit rulesChanged();
 }
 
-void LogHighlighter::highlightBlock(const QString &text)
+void LogHighlighter::compile()
 {
-    if (rules_.isEmpty())
-        return;
+    ++generation_;
+    nodes_.assign(1, Node());
+    formats_.clear();
+    lengths_.clear();
 
-    // For each rule, find all occurrences in this block and set format
-    for (const HighlightRule &r : rules_) {
-        if (!r.enabled)
-            continue;
-        if (r.pattern.isEmpty())
+    for (int r = 0; r < rules_.size(); ++r) {
+        const HighlightRule &rule = rules_[r];
+        QTextCharFormat fmt;
+        fmt.setForeground(Qt::black);
+        fmt.setBackground(rule.color);
+        formats_.append(fmt);
+        lengths_.append(rule.pattern.length());
+        if (!rule.enabled || rule.pattern.isEmpty())
             continue;
 
-        QString pat = r.pattern;
-        int patLen = pat.length();
-        int start = 0;
-        // Case-insensitive by default
-        while (true) {
-            int idx = text.indexOf(pat, start, Qt::CaseInsensitive);
-            if (idx == -1)
-                break;
-            QTextCharFormat fmt;
-            fmt.setForeground(Qt::black);
-            fmt.setBackground(r.color);
-            setFormat(idx, patLen, fmt);
-            start = idx + std::max(1, patLen);
+        // Case-insensitive: patterns and text are both case-folded
+        const QString pat = rule.pattern.toCaseFolded();
+        int state = 0;
+        for (const QChar ch : pat) {
+            const ushort c = ch.unicode();
+            auto &edges = nodes_[size_t(state)].next;
+            auto it = std::lower_bound(edges.begin(), edges.end(), std::make_pair(c, 0));
+            if (it != edges.end() && it->first == c) {
+                state = it->second;
+            } else {
+                const int node = int(nodes_.size());
+                edges.insert(it, std::make_pair(c, node));
+                nodes_.emplace_back();
+                state = node;
+            }
+        }
+        nodes_[size_t(state)].rules.append(r);
+    }
+
+    // Breadth-first: fail links of a node depend on shallower nodes only
+    std::vector<int> queue;
+    for (const auto &e : nodes_[0].next)
+        queue.push_back(e.second);
+    for (size_t qi = 0; qi < queue.size(); ++qi) {
+        const int u = queue[qi];
+        for (const auto &e : nodes_[size_t(u)].next) {
+            const int v = e.second;
+            int f = nodes_[size_t(u)].fail;
+            while (true) {
+                const auto &edges = nodes_[size_t(f)].next;
+                auto it = std::lower_bound(edges.begin(), edges.end(), std::make_pair(e.first, 0));
+                if (it != edges.end() && it->first == e.first) {
+                    f = it->second;
+                    break;
+                }
+                if (f == 0)
+                    break;
+                f = nodes_[size_t(f)].fail;
+            }
+            Node &node = nodes_[size_t(v)];
+            node.fail = f;
+            node.output = nodes_[size_t(f)].rules.isEmpty() ? nodes_[size_t(f)].output : f;
+            queue.push_back(v);
+        }
+    }
+}
+
+int LogHighlighter::step(int state, ushort c) const
+{
+    while (true) {
+        const auto &edges = nodes_[size_t(state)].next;
+        auto it = std::lower_bound(edges.begin(), edges.end(), std::make_pair(c, 0));
+        if (it != edges.end() && it->first == c)
+            return it->second;
+        if (state == 0)
+            return 0;
+        state = nodes_[size_t(state)].fail;
+    }
+}
+
+void LogHighlighter::highlightLine(const QString &text, QVector<QTextLayout::FormatRange> &formats) const
+{
+    if (nodes_.size() <= 1)
+        return;
+
+    // Matches of each rule are taken left to right without overlapping, as
+    // repeated indexOf() would find them
+    struct Hit {
+        int rule;
+        int start;
+    };
+    std::vector<Hit> hits;
+    std::vector<int> nextStart(size_t(rules_.size()), 0);
+    int state = 0;
+    const QChar *chars = text.constData();
+    for (int i = 0; i < text.size(); ++i) {
+        state = step(state, chars[i].toCaseFolded().unicode());
+        const Node &here = nodes_[size_t(state)];
+        for (int s = here.rules.isEmpty() ? here.output : state; s != 0; s = nodes_[size_t(s)].output) {
+            for (int r : nodes_[size_t(s)].rules) {
+                const int start = i + 1 - lengths_[r];
+                if (start >= nextStart[size_t(r)]) {
+                    hits.push_back({r, start});
+                    nextStart[size_t(r)] = i + 1;
+                }
+            }
         }
     }
+
+    // Later rules are drawn over earlier ones, as before
+    std::stable_sort(hits.begin(), hits.end(), [](const Hit &a, const Hit &b) { return a.rule < b.rule; });
+    for (const Hit &h : hits) {
+        QTextLayout::FormatRange range;
+        range.start = h.start;
+        range.length = lengths_[h.rule];
+        range.format = formats_[h.rule];
+        formats.append(range);
+    }
 }
 
 void LogHighlighter::loadFromSettings()
@@ -61,7 +151,8 @@ void LogHighlighter::loadFromSettings()
     }
     s.endGroup();
     rules_ = vec;
-    rehighlight();
+    compile();
+    emit rulesChanged();
 }
 
 void LogHighlighter::saveToSettings() const
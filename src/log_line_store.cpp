@@ -0,0 +1,362 @@
+#include "log_line_store.h"
+#include "search_helper.h"
+#include <QDir>
+#include <QFile>
+#include <QIODevice>
+#include <QTemporaryFile>
+#include <algorithm>
+#include <cstring>
+
+LogLineStore::LogLineStore() = default;
+
+LogLineStore::~LogLineStore() = default;
+
+LogLineStore::Chunk &LogLineStore::newChunk()
+{
+    Chunk c;
+    c.data.reserve(kChunkSize);
+    c.starts.reserve(kChunkSize / 64);
+    c.firstLine = lines_;
+    chunks_.push_back(std::move(c));
+    return chunks_.back();
+}
+
+void LogLineStore::append(const char *utf8, int len)
+{
+    const char *p = utf8;
+    const char *end = utf8 + len;
+    while (p < end) {
+        const char *nl = static_cast<const char *>(memchr(p, '\n', size_t(end - p)));
+        const char *segEnd = nl ? nl + 1 : end;
+        const int segLen = int(segEnd - p);
+        const bool continues = openLine();
+
+        if (chunks_.empty())
+            newChunk();
+        Chunk *c = &chunks_.back();
+        if (c->data.size() + segLen > kChunkSize && !c->data.isEmpty()
+            && !(continues && c->starts.size() == 1)) {
+            if (continues) {
+                // Move the unfinished line along so lines never straddle chunks
+                const int start = int(c->starts.back());
+                const QByteArray tail = c->data.mid(start);
+                c->data.truncate(start);
+                c->starts.pop_back();
+                --lines_;
+                c->data.squeeze();
+                c = &newChunk();
+                c->starts.push_back(0);
+                ++lines_;
+                c->data.append(tail);
+            } else {
+                c->data.squeeze();
+                c = &newChunk();
+            }
+        }
+
+        if (!continues) {
+            c->starts.push_back(quint32(c->data.size()));
+            ++lines_;
+        }
+        c->data.append(p, segLen);
+        bytes_ += quint64(segLen);
+        residentBytes_ += segLen;
+        lastByte_ = segEnd[-1];
+
+        const int lineLen = c->data.size() - int(c->starts.back()) - (nl ? 1 : 0);
+        maxLineLength_ = std::max(maxLineLength_, lineLen);
+        p = segEnd;
+    }
+    enforceLimit();
+}
+
+void LogLineStore::clear()
+{
+    chunks_.clear();
+    cache_.clear();
+    firstResident_ = 0;
+    residentBytes_ = 0;
+    spillFile_.reset();
+    spillSize_ = 0;
+    spillError_.clear();
+    mappedFile_.reset();
+    mapped_ = nullptr;
+    mappedSize_ = 0;
+    mappedBytes_ = 0;
+    lines_ = 0;
+    bytes_ = 0;
+    lastByte_ = 0;
+    maxLineLength_ = 0;
+}
+
+bool LogLineStore::mapFile(const QString &path, QString *error)
+{
+    clear();
+    auto file = std::make_shared<QFile>(path);
+    if (!file->open(QIODevice::ReadOnly)) {
+        if (error)
+            *error = file->errorString();
+        return false;
+    }
+    const qint64 size = file->size();
+    if (size == 0)
+        return true;
+    uchar *data = file->map(0, size);
+    if (!data) {
+        if (error)
+            *error = file->errorString();
+        return false;
+    }
+    mappedFile_ = file;
+    mapped_ = reinterpret_cast<const char *>(data);
+    mappedSize_ = size;
+    return true;
+}
+
+void LogLineStore::appendMapped(int size, std::vector<quint32> starts)
+{
+    if (size <= 0 || mappedBytes_ + size > mappedSize_)
+        return;
+    Chunk c;
+    // Points into the mapping; nothing is copied unless the chunk is written to
+    c.data = QByteArray::fromRawData(mapped_ + mappedBytes_, size);
+    c.firstLine = lines_;
+    for (size_t i = 0; i < starts.size(); ++i) {
+        const int end = i + 1 < starts.size() ? int(starts[i + 1]) - 1
+                                              : size - (c.data.at(size - 1) == '\n' ? 1 : 0);
+        maxLineLength_ = std::max(maxLineLength_, end - int(starts[i]));
+    }
+    lines_ += starts.size();
+    c.starts = std::move(starts);
+    chunks_.push_back(std::move(c));
+    // Mapped text is on disk already; it never counts towards the limit
+    firstResident_ = chunks_.size();
+    mappedBytes_ += size;
+    bytes_ += quint64(size);
+    lastByte_ = mapped_[mappedBytes_ - 1];
+}
+
+void LogLineStore::setScrollbackLimit(qint64 bytes, const QString &dir)
+{
+    limit_ = std::max<qint64>(0, bytes);
+    spillDir_ = dir;
+    enforceLimit();
+}
+
+void LogLineStore::enforceLimit()
+{
+    // The last chunk is still being filled and always stays in memory
+    while (limit_ > 0 && residentBytes_ > limit_ && firstResident_ + 1 < chunks_.size()) {
+        Chunk &c = chunks_[firstResident_];
+        const int size = c.data.size();
+        if (!spill(c))
+            return;
+        residentBytes_ -= size;
+        ++firstResident_;
+    }
+}
+
+bool LogLineStore::spill(Chunk &c)
+{
+    if (!spillError_.isEmpty())
+        return false;
+    if (!spillFile_) {
+        QDir().mkpath(spillDir_);
+        spillFile_.reset(new QTemporaryFile(QDir(spillDir_).filePath("scrollback_XXXXXX.tmp")));
+        if (!spillFile_->open()) {
+            spillError_ = spillFile_->errorString();
+            spillFile_.reset();
+            return false;
+        }
+    }
+    // Flushed so snapshot readers with their own handle see it
+    if (!spillFile_->seek(spillSize_) || spillFile_->write(c.data) != c.data.size() || !spillFile_->flush()) {
+        spillError_ = spillFile_->errorString();
+        return false;
+    }
+    c.spillOffset = spillSize_;
+    c.spillSize = c.data.size();
+    spillSize_ += c.spillSize;
+    c.data = QByteArray();
+    std::vector<quint32>().swap(c.starts);
+    return true;
+}
+
+const LogLineStore::Chunk &LogLineStore::loaded(int ci) const
+{
+    Chunk &c = chunks_[size_t(ci)];
+    if (size_t(ci) >= firstResident_ || !c.starts.empty())
+        return c;
+
+    // Make room first so c is never the one dropped
+    if (int(cache_.size()) >= kCachedChunks) {
+        Chunk &old = chunks_[size_t(cache_.front())];
+        old.data = QByteArray();
+        std::vector<quint32>().swap(old.starts);
+        cache_.pop_front();
+    }
+    cache_.push_back(ci);
+
+    const quint64 lineCount = chunks_[size_t(ci) + 1].firstLine - c.firstLine;
+    if (spillFile_->seek(c.spillOffset))
+        c.data = spillFile_->read(c.spillSize);
+    if (c.data.size() != c.spillSize) {
+        // Unreadable spill file: keep the line numbering intact with blank lines
+        c.data = QByteArray(int(lineCount), '\n');
+    }
+    c.starts.reserve(size_t(lineCount));
+    c.starts.push_back(0);
+    const char *begin = c.data.constData();
+    const char *end = begin + c.data.size();
+    for (const char *p = begin; (p = static_cast<const char *>(memchr(p, '\n', size_t(end - p)))) && ++p < end;)
+        c.starts.push_back(quint32(p - begin));
+    return c;
+}
+
+QByteArray LogLineStore::chunkData(int ci) const
+{
+    const Chunk &c = chunks_[size_t(ci)];
+    if (size_t(ci) >= firstResident_ || !c.starts.empty())
+        return c.data;
+    // Read spilled text without disturbing the cache
+    QByteArray data;
+    if (spillFile_->seek(c.spillOffset))
+        data = spillFile_->read(c.spillSize);
+    return data;
+}
+
+qint64 LogLineStore::memoryUsage() const
+{
+    qint64 total = 0;
+    for (const Chunk &c : chunks_)
+        total += c.data.capacity() + qint64(c.starts.capacity() * sizeof(quint32)) + qint64(sizeof(Chunk));
+    return total;
+}
+
+int LogLineStore::chunkForLine(quint64 index) const
+{
+    auto it = std::upper_bound(chunks_.begin(), chunks_.end(), index,
+                               [](quint64 i, const Chunk &c) { return i < c.firstLine; });
+    return int(it - chunks_.begin()) - 1;
+}
+
+int LogLineStore::chunkLineEnd(const Chunk &c, size_t local) const
+{
+    if (local + 1 < c.starts.size())
+        return int(c.starts[local + 1]) - 1;
+    // Last line of the chunk: terminated unless it is the open last line
+    const int size = c.data.size();
+    return (size > 0 && c.data.at(size - 1) == '\n') ? size - 1 : size;
+}
+
+quint64 LogLineStore::lineAt(const Chunk &c, int offset) const
+{
+    auto it = std::upper_bound(c.starts.begin(), c.starts.end(), quint32(offset));
+    return c.firstLine + quint64(it - c.starts.begin()) - 1;
+}
+
+LogLineStore::LineRef LogLineStore::line(quint64 index) const
+{
+    LineRef ref;
+    if (index >= lines_)
+        return ref;    // trailing empty line
+    const Chunk &c = loaded(chunkForLine(index));
+    const size_t local = size_t(index - c.firstLine);
+    const int start = int(c.starts[local]);
+    ref.data = c.data.constData() + start;
+    ref.size = chunkLineEnd(c, local) - start;
+    return ref;
+}
+
+QString LogLineStore::lineText(quint64 index) const
+{
+    const LineRef ref = line(index);
+    return QString::fromUtf8(ref.data, ref.size);
+}
+
+const char *LogLineStore::search(const char *p, const char *end, const QByteArray &needle) const
+{
+    const char *hit = SearchHelper::find(p, end, needle.constData(), needle.size());
+    return hit ? hit : end;
+}
+
+bool LogLineStore::findNext(const QByteArray &needle, quint64 &line, int &byteColumn) const
+{
+    if (needle.isEmpty() || line >= lines_)
+        return false;
+    for (int ci = chunkForLine(line); ci < int(chunks_.size()); ++ci) {
+        const Chunk &c = loaded(ci);
+        const char *begin = c.data.constData();
+        const char *p = begin;
+        const char *end = begin + c.data.size();
+        if (line >= c.firstLine && line - c.firstLine < c.starts.size())
+            p = std::min(end, begin + c.starts[size_t(line - c.firstLine)] + byteColumn);
+        const char *hit = search(p, end, needle);
+        if (hit != end) {
+            line = lineAt(c, int(hit - begin));
+            byteColumn = int(hit - begin) - int(c.starts[size_t(line - c.firstLine)]);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool LogLineStore::findPrevious(const QByteArray &needle, quint64 &line, int &byteColumn) const
+{
+    if (needle.isEmpty() || chunks_.empty())
+        return false;
+    // Position as a chunk and byte limit; matches must start before it
+    int ci = chunkForLine(std::min(line, lines_ - 1));
+    int limit;
+    if (line >= lines_) {
+        limit = chunks_.back().data.size();
+        ci = int(chunks_.size()) - 1;
+    } else {
+        const Chunk &c = loaded(ci);
+        limit = int(c.starts[size_t(line - c.firstLine)]) + byteColumn;
+    }
+    for (; ci >= 0; --ci) {
+        const Chunk &c = loaded(ci);
+        const char *begin = c.data.constData();
+        // A match starting before limit ends at most needle.size() - 1 past it
+        const char *end = begin + std::min(c.data.size(), limit + needle.size() - 1);
+        const char *last = SearchHelper::findLast(begin, end, needle.constData(), needle.size());
+        if (last) {
+            line = lineAt(c, int(last - begin));
+            byteColumn = int(last - begin) - int(c.starts[size_t(line - c.firstLine)]);
+            return true;
+        }
+        if (ci > 0)
+            limit = loaded(ci - 1).data.size();
+    }
+    return false;
+}
+
+LogLineStore::Snapshot LogLineStore::snapshot() const
+{
+    Snapshot snap;
+    snap.blocks.reserve(chunks_.size());
+    for (const Chunk &c : chunks_) {
+        Snapshot::Block b;
+        if (!c.starts.empty())
+            b.data = c.data;
+        b.firstLine = c.firstLine;
+        b.spillOffset = c.spillOffset;
+        b.spillSize = c.spillSize;
+        snap.blocks.push_back(b);
+    }
+    if (spillFile_)
+        snap.spillPath = spillFile_->fileName();
+    snap.mapping = mappedFile_;
+    return snap;
+}
+
+bool LogLineStore::writeTo(QIODevice *out) const
+{
+    for (int ci = 0; ci < int(chunks_.size()); ++ci) {
+        const QByteArray data = chunkData(ci);
+        if (out->write(data) != data.size())
+            return false;
+    }
+    return true;
+}
@@ -0,0 +1,614 @@
+#include "log_view.h"
+#include "log_highlighter.h"
+#include "line_indexer.h"
+#include <QApplication>
+#include <QClipboard>
+#include <QContextMenuEvent>
+#include <QKeyEvent>
+#include <QMenu>
+#include <QMouseEvent>
+#include <QPainter>
+#include <QScrollBar>
+#include <QTextLayout>
+#include <algorithm>
+#include <climits>
+#include <cstring>
+
+LogView::LogView(QWidget *parent)
+    : QAbstractScrollArea(parent)
+{
+    setFocusPolicy(Qt::StrongFocus);
+    viewport()->setCursor(Qt::IBeamCursor);
+    viewport()->setBackgroundRole(QPalette::Base);
+    verticalScrollBar()->setSingleStep(1);
+    updateMetrics();
+
+    indexer_ = new LineIndexer(this);
+    connect(indexer_, &LineIndexer::pieceIndexed, this, [this](int size, const std::vector<quint32> &starts) {
+        const quint64 oldLastRow = rowCount() - 1;
+        store_.appendMapped(size, starts);
+        afterAppend(oldLastRow);
+        emit loadProgress(store_.mappedBytes(), store_.mappedSize());
+    });
+    connect(indexer_, &LineIndexer::finished, this, [this]() {
+        if (autoScroll_)
+            verticalScrollBar()->setValue(verticalScrollBar()->maximum());
+        emit loadFinished();
+    });
+    connect(indexer_, &LineIndexer::cancelled, this, &LogView::loadCancelled);
+}
+
+void LogView::appendText(const QString &text)
+{
+    if (text.isEmpty())
+        return;
+    const quint64 oldLastRow = rowCount() - 1;
+    store_.append(text);
+    afterAppend(oldLastRow);
+}
+
+void LogView::appendUtf8(const char *data, int len)
+{
+    if (len <= 0)
+        return;
+    const quint64 oldLastRow = rowCount() - 1;
+    store_.append(data, len);
+    afterAppend(oldLastRow);
+}
+
+void LogView::afterAppend(quint64 oldLastRow)
+{
+    if (!hiddenPrefixes_.isEmpty())
+        extendFilterIndex();
+    // The old last row may have grown and rows after it are new
+    while (!searchRows_.empty() && searchFirstRow_ + searchRows_.size() > oldLastRow)
+        searchRows_.pop_back();
+    updateScrollBars();
+    // A file being loaded stays at the top until it is all there
+    if (autoScroll_ && !indexer_->isRunning())
+        verticalScrollBar()->setValue(verticalScrollBar()->maximum());
+    viewport()->update();
+}
+
+void LogView::clear()
+{
+    indexer_->cancel();
+    store_.clear();
+    ruleFormats_.clear();
+    visibleLines_.clear();
+    filteredUpTo_ = 0;
+    resetSearchWindow();
+    anchor_ = cursor_ = Position();
+    updateScrollBars();
+    viewport()->update();
+}
+
+bool LogView::openMapped(const QString &path, QString *error)
+{
+    clear();
+    if (!store_.mapFile(path, error))
+        return false;
+    indexer_->start(store_.mapping(), store_.mappedData(), store_.mappedSize());
+    return true;
+}
+
+bool LogView::isLoading() const
+{
+    return indexer_->isRunning();
+}
+
+void LogView::setHighlighter(LogHighlighter *highlighter)
+{
+    if (highlighter_)
+        disconnect(highlighter_, nullptr, viewport(), nullptr);
+    highlighter_ = highlighter;
+    ruleFormats_.clear();
+    if (highlighter_) {
+        ruleFormatsGeneration_ = highlighter_->generation();
+        // Only a repaint; the visible lines are highlighted again as they are drawn
+        connect(highlighter_, &LogHighlighter::rulesChanged, viewport(), QOverload<>::of(&QWidget::update));
+    }
+    viewport()->update();
+}
+
+void LogView::setSearchHighlight(const QString &term, const QColor &background, const QColor &foreground)
+{
+    if (term != searchTerm_)
+        resetSearchWindow();
+    searchTerm_ = term;
+    searchBackground_ = background;
+    searchForeground_ = foreground;
+    viewport()->update();
+}
+
+void LogView::setHiddenPrefixes(const QVector<QByteArray> &prefixes)
+{
+    // Keep the top visible line in place across the re-filter
+    const quint64 topLine = lineForRow(quint64(verticalScrollBar()->value()));
+    hiddenPrefixes_ = prefixes;
+    visibleLines_.clear();
+    filteredUpTo_ = 0;
+    resetSearchWindow();
+    if (!hiddenPrefixes_.isEmpty())
+        extendFilterIndex();
+    updateScrollBars();
+    verticalScrollBar()->setValue(int(rowForLine(topLine)));
+    viewport()->update();
+}
+
+bool LogView::lineHidden(quint64 line) const
+{
+    const LogLineStore::LineRef ref = store_.line(line);
+    for (const QByteArray &prefix : hiddenPrefixes_) {
+        if (ref.size >= prefix.size() && memcmp(ref.data, prefix.constData(), size_t(prefix.size())) == 0)
+            return true;
+    }
+    return false;
+}
+
+void LogView::extendFilterIndex()
+{
+    // Only complete lines are filtered; the last line may still grow
+    const quint64 complete = store_.lineCount() - 1;
+    for (quint64 line = filteredUpTo_; line < complete; ++line) {
+        if (!lineHidden(line))
+            visibleLines_.push_back(line);
+    }
+    filteredUpTo_ = complete;
+}
+
+quint64 LogView::rowCount() const
+{
+    if (hiddenPrefixes_.isEmpty())
+        return store_.lineCount();
+    return quint64(visibleLines_.size()) + 1;
+}
+
+quint64 LogView::lineForRow(quint64 row) const
+{
+    if (hiddenPrefixes_.isEmpty())
+        return row;
+    return row < visibleLines_.size() ? visibleLines_[size_t(row)] : store_.lineCount() - 1;
+}
+
+quint64 LogView::rowForLine(quint64 line) const
+{
+    if (hiddenPrefixes_.isEmpty())
+        return line;
+    // Hidden lines map to the next row that is shown
+    return quint64(std::lower_bound(visibleLines_.begin(), visibleLines_.end(), line) - visibleLines_.begin());
+}
+
+void LogView::updateMetrics()
+{
+    const QFontMetrics fm(font());
+    lineHeight_ = qMax(1, fm.lineSpacing());
+    charWidth_ = qMax(1, fm.averageCharWidth());
+    updateScrollBars();
+    viewport()->update();
+}
+
+int LogView::pageRows() const
+{
+    return qMax(1, viewport()->height() / lineHeight_);
+}
+
+void LogView::updateScrollBars()
+{
+    const quint64 rows = rowCount();
+    const int page = pageRows();
+    QScrollBar *v = verticalScrollBar();
+    v->setPageStep(page);
+    v->setRange(0, int(qMin<quint64>(rows > quint64(page) ? rows - quint64(page) : 0, quint64(INT_MAX))));
+
+    const int width = qMin(store_.maxLineLength(), kMaxDisplayColumns) * charWidth_ + 2 * charWidth_;
+    QScrollBar *h = horizontalScrollBar();
+    h->setPageStep(viewport()->width());
+    h->setSingleStep(charWidth_ * 4);
+    h->setRange(0, qMax(0, width - viewport()->width()));
+}
+
+QString LogView::displayText(quint64 line) const
+{
+    const LogLineStore::LineRef ref = store_.line(line);
+    int size = ref.size;
+    if (size > 0 && ref.data[size - 1] == '\r')
+        --size;
+    QString text = QString::fromUtf8(ref.data, size);
+    if (text.size() > kMaxDisplayColumns)
+        text.truncate(kMaxDisplayColumns);
+    return text;
+}
+
+void LogView::resetSearchWindow()
+{
+    searchRows_.clear();
+    searchFirstRow_ = 0;
+}
+
+void LogView::updateSearchWindow(quint64 firstRow, quint64 rows)
+{
+    if (searchTerm_.isEmpty())
+        return;
+    const quint64 from = firstRow > quint64(kSearchMargin) ? firstRow - quint64(kSearchMargin) : 0;
+    const quint64 to = qMin(rowCount(), firstRow + rows + quint64(kSearchMargin));
+    auto matchesOf = [this](quint64 row) {
+        QVector<int> columns;
+        const QString text = displayText(lineForRow(row));
+        for (int idx = text.indexOf(searchTerm_); idx >= 0; idx = text.indexOf(searchTerm_, idx + searchTerm_.size()))
+            columns.append(idx);
+        return columns;
+    };
+
+    // Keep what overlaps, search only the rows scrolled into the window
+    if (searchRows_.empty() || from > searchFirstRow_ + searchRows_.size()
+        || to < searchFirstRow_) {
+        searchRows_.clear();
+        searchFirstRow_ = from;
+    }
+    while (searchFirstRow_ > from)
+        searchRows_.push_front(matchesOf(--searchFirstRow_));
+    while (searchFirstRow_ + searchRows_.size() < to)
+        searchRows_.push_back(matchesOf(searchFirstRow_ + searchRows_.size()));
+    // Drop rows that fell too far outside the viewport
+    while (searchFirstRow_ < from && !searchRows_.empty()) {
+        searchRows_.pop_front();
+        ++searchFirstRow_;
+    }
+    while (searchFirstRow_ + searchRows_.size() > to && !searchRows_.empty())
+        searchRows_.pop_back();
+}
+
+void LogView::layoutLine(QTextLayout &layout, quint64 line, const QString &text,
+                         const QVector<int> *matches) const
+{
+    QVector<QTextLayout::FormatRange> formats = ruleFormats(line, text);
+
+    if (matches) {
+        for (int idx : *matches) {
+            QTextLayout::FormatRange range;
+            range.start = idx;
+            range.length = searchTerm_.size();
+            range.format.setBackground(searchBackground_);
+            range.format.setForeground(searchForeground_);
+            formats.append(range);
+        }
+    }
+
+    if (hasSelection()) {
+        const Position s = selectionStart();
+        const Position e = selectionEnd();
+        if (line >= s.line && line <= e.line) {
+            const int from = line == s.line ? s.column : 0;
+            const int to = line == e.line ? e.column : text.size() + 1;
+            QTextLayout::FormatRange range;
+            range.start = from;
+            range.length = qMax(0, to - from);
+            range.format.setBackground(palette().brush(QPalette::Highlight));
+            range.format.setForeground(palette().brush(QPalette::HighlightedText));
+            formats.append(range);
+        }
+    }
+
+    QTextOption option;
+    option.setWrapMode(QTextOption::NoWrap);
+    layout.setTextOption(option);
+    layout.setFont(font());
+    layout.setFormats(formats);
+    layout.beginLayout();
+    QTextLine tl = layout.createLine();
+    if (tl.isValid())
+        tl.setLineWidth(qMax(1, (text.size() + 1) * charWidth_ * 4));
+    layout.endLayout();
+}
+
+QVector<QTextLayout::FormatRange> LogView::ruleFormats(quint64 line, const QString &text) const
+{
+    QVector<QTextLayout::FormatRange> formats;
+    if (!highlighter_)
+        return formats;
+    if (highlighter_->generation() != ruleFormatsGeneration_) {
+        ruleFormats_.clear();
+        ruleFormatsGeneration_ = highlighter_->generation();
+    }
+    auto it = ruleFormats_.constFind(line);
+    if (it != ruleFormats_.constEnd())
+        return it.value();
+    highlighter_->highlightLine(text, formats);
+    // The last line may still grow
+    if (line + 1 < store_.lineCount())
+        ruleFormats_.insert(line, formats);
+    return formats;
+}
+
+void LogView::pruneRuleFormats(quint64 firstRow, quint64 rows)
+{
+    const quint64 window = rows + 2 * quint64(kSearchMargin);
+    if (quint64(ruleFormats_.size()) <= 2 * window)
+        return;
+    const quint64 from = firstRow > quint64(kSearchMargin) ? firstRow - quint64(kSearchMargin) : 0;
+    const quint64 to = qMin(rowCount(), firstRow + rows + quint64(kSearchMargin));
+    if (from >= to) {
+        ruleFormats_.clear();
+        return;
+    }
+    const quint64 firstLine = lineForRow(from);
+    const quint64 lastLine = lineForRow(to - 1);
+    for (auto it = ruleFormats_.begin(); it != ruleFormats_.end();) {
+        if (it.key() < firstLine || it.key() > lastLine)
+            it = ruleFormats_.erase(it);
+        else
+            ++it;
+    }
+}
+
+void LogView::paintEvent(QPaintEvent *)
+{
+    QPainter painter(viewport());
+    painter.setPen(palette().color(QPalette::Text));
+
+    const quint64 first = quint64(verticalScrollBar()->value());
+    const quint64 rows = rowCount();
+    const int x = -horizontalScrollBar()->value();
+    const int visible = viewport()->height() / lineHeight_ + 1;
+    updateSearchWindow(first, quint64(visible));
+    for (int i = 0; i < visible && first + quint64(i) < rows; ++i) {
+        const quint64 row = first + quint64(i);
+        const quint64 line = lineForRow(row);
+        const QString text = displayText(line);
+        const QVector<int> *matches = nullptr;
+        if (row >= searchFirstRow_ && row - searchFirstRow_ < searchRows_.size())
+            matches = &searchRows_[size_t(row - searchFirstRow_)];
+        QTextLayout layout(text);
+        layoutLine(layout, line, text, matches);
+        layout.draw(&painter, QPointF(x, i * lineHeight_));
+    }
+    pruneRuleFormats(first, quint64(visible));
+}
+
+void LogView::resizeEvent(QResizeEvent *event)
+{
+    QAbstractScrollArea::resizeEvent(event);
+    const bool atEnd = verticalScrollBar()->value() == verticalScrollBar()->maximum();
+    updateScrollBars();
+    if (atEnd && autoScroll_)
+        verticalScrollBar()->setValue(verticalScrollBar()->maximum());
+}
+
+void LogView::changeEvent(QEvent *event)
+{
+    QAbstractScrollArea::changeEvent(event);
+    if (event->type() == QEvent::FontChange || event->type() == QEvent::StyleChange)
+        updateMetrics();
+}
+
+LogView::Position LogView::positionAt(const QPoint &pt) const
+{
+    Position pos;
+    const quint64 rows = rowCount();
+    const qint64 row = qint64(verticalScrollBar()->value()) + (pt.y() < 0 ? -1 : pt.y() / lineHeight_);
+    if (row < 0)
+        return pos;
+    if (quint64(row) >= rows) {
+        pos.line = lineForRow(rows - 1);
+        pos.column = displayText(pos.line).size();
+        return pos;
+    }
+    pos.line = lineForRow(quint64(row));
+    const QString text = displayText(pos.line);
+    QTextLayout layout(text);
+    layoutLine(layout, pos.line, text);
+    pos.column = layout.lineAt(0).xToCursor(pt.x() + horizontalScrollBar()->value());
+    return pos;
+}
+
+void LogView::mousePressEvent(QMouseEvent *event)
+{
+    if (event->button() != Qt::LeftButton) {
+        QAbstractScrollArea::mousePressEvent(event);
+        return;
+    }
+    const Position pos = positionAt(event->pos());
+    if (!(event->modifiers() & Qt::ShiftModifier))
+        anchor_ = pos;
+    cursor_ = pos;
+    selecting_ = true;
+    viewport()->update();
+}
+
+void LogView::mouseMoveEvent(QMouseEvent *event)
+{
+    if (!selecting_)
+        return;
+    // Dragging past the top or bottom edge scrolls
+    if (event->pos().y() < 0)
+        verticalScrollBar()->triggerAction(QAbstractSlider::SliderSingleStepSub);
+    else if (event->pos().y() > viewport()->height())
+        verticalScrollBar()->triggerAction(QAbstractSlider::SliderSingleStepAdd);
+    cursor_ = positionAt(event->pos());
+    viewport()->update();
+}
+
+void LogView::mouseReleaseEvent(QMouseEvent *event)
+{
+    if (event->button() == Qt::LeftButton && selecting_) {
+        selecting_ = false;
+        if (hasSelection() && QApplication::clipboard()->supportsSelection())
+            QApplication::clipboard()->setText(selectedText(), QClipboard::Selection);
+    }
+}
+
+void LogView::mouseDoubleClickEvent(QMouseEvent *event)
+{
+    if (event->button() != Qt::LeftButton)
+        return;
+    // Select the word under the mouse
+    Position pos = positionAt(event->pos());
+    const QString text = displayText(pos.line);
+    auto isWord = [&text](int i) { return i >= 0 && i < text.size() && (text[i].isLetterOrNumber() || text[i] == '_'); };
+    int from = pos.column;
+    int to = pos.column;
+    while (isWord(from - 1))
+        --from;
+    while (isWord(to))
+        ++to;
+    setSelection({pos.line, from}, {pos.line, to});
+    selecting_ = false;
+}
+
+void LogView::keyPressEvent(QKeyEvent *event)
+{
+    QScrollBar *v = verticalScrollBar();
+    if (event->matches(QKeySequence::Copy)) {
+        copy();
+    } else if (event->matches(QKeySequence::SelectAll)) {
+        selectAll();
+    } else if (event->matches(QKeySequence::MoveToStartOfDocument)) {
+        v->setValue(0);
+    } else if (event->matches(QKeySequence::MoveToEndOfDocument)) {
+        v->setValue(v->maximum());
+    } else if (event->key() == Qt::Key_PageUp) {
+        v->triggerAction(QAbstractSlider::SliderPageStepSub);
+    } else if (event->key() == Qt::Key_PageDown) {
+        v->triggerAction(QAbstractSlider::SliderPageStepAdd);
+    } else if (event->key() == Qt::Key_Up) {
+        v->triggerAction(QAbstractSlider::SliderSingleStepSub);
+    } else if (event->key() == Qt::Key_Down) {
+        v->triggerAction(QAbstractSlider::SliderSingleStepAdd);
+    } else {
+        QAbstractScrollArea::keyPressEvent(event);
+    }
+}
+
+void LogView::contextMenuEvent(QContextMenuEvent *event)
+{
+    QMenu menu(this);
+    QAction *copyAction = menu.addAction(tr("Copy"), this, &LogView::copy, QKeySequence::Copy);
+    copyAction->setEnabled(hasSelection());
+    menu.addAction(tr("Select All"), this, &LogView::selectAll, QKeySequence::SelectAll);
+    menu.exec(event->globalPos());
+}
+
+void LogView::setSelection(const Position &anchor, const Position &cursor)
+{
+    anchor_ = anchor;
+    cursor_ = cursor;
+    viewport()->update();
+}
+
+QString LogView::selectedText() const
+{
+    if (!hasSelection())
+        return QString();
+    const Position s = selectionStart();
+    const Position e = selectionEnd();
+    QString out;
+    for (quint64 line = s.line; line <= e.line; ++line) {
+        const QString text = store_.lineText(line);
+        const int from = line == s.line ? qMin(s.column, text.size()) : 0;
+        const int to = line == e.line ? qMin(e.column, text.size()) : text.size();
+        out += text.midRef(from, to - from);
+        if (line != e.line)
+            out += '\n';
+    }
+    return out;
+}
+
+void LogView::selectAll()
+{
+    setSelection({0, 0}, endPosition());
+}
+
+void LogView::copy() const
+{
+    if (hasSelection())
+        QApplication::clipboard()->setText(selectedText());
+}
+
+void LogView::moveCursorToStart()
+{
+    setSelection({0, 0}, {0, 0});
+}
+
+LogView::Position LogView::endPosition() const
+{
+    const quint64 last = store_.lineCount() - 1;
+    return {last, store_.lineText(last).size()};
+}
+
+void LogView::moveCursorToEnd()
+{
+    setSelection(endPosition(), endPosition());
+}
+
+void LogView::ensureVisible(const Position &pos)
+{
+    QScrollBar *v = verticalScrollBar();
+    const int row = int(qMin<quint64>(rowForLine(pos.line), quint64(INT_MAX)));
+    if (row < v->value() || row >= v->value() + pageRows())
+        v->setValue(row - pageRows() / 2);
+
+    const QString text = displayText(pos.line);
+    QTextLayout layout(text);
+    layoutLine(layout, pos.line, text);
+    const int x = int(layout.lineAt(0).cursorToX(qMin(pos.column, text.size())));
+    QScrollBar *h = horizontalScrollBar();
+    if (x < h->value() || x > h->value() + viewport()->width() - 2 * charWidth_)
+        h->setValue(x - viewport()->width() / 2);
+}
+
+int LogView::byteToColumn(quint64 line, int byteColumn) const
+{
+    const LogLineStore::LineRef ref = store_.line(line);
+    const int n = qMin(byteColumn, ref.size);
+    for (int i = 0; i < n; ++i) {
+        if (uchar(ref.data[i]) >= 0x80)
+            return QString::fromUtf8(ref.data, n).size();
+    }
+    return n;
+}
+
+int LogView::columnToByte(quint64 line, int column) const
+{
+    const LogLineStore::LineRef ref = store_.line(line);
+    const int n = qMin(column, ref.size);
+    for (int i = 0; i < n; ++i) {
+        if (uchar(ref.data[i]) >= 0x80)
+            return QString::fromUtf8(ref.data, ref.size).left(column).toUtf8().size();
+    }
+    return n;
+}
+
+bool LogView::find(const QString &term, bool backward)
+{
+    const QByteArray needle = term.toUtf8();
+    if (needle.isEmpty() || needle.contains('\n'))
+        return false;
+
+    const Position from = backward ? selectionStart() : selectionEnd();
+    quint64 line = from.line;
+    int byteColumn = columnToByte(line, from.column);
+    const bool found = backward ? store_.findPrevious(needle, line, byteColumn)
+                                : store_.findNext(needle, line, byteColumn);
+    if (!found)
+        return false;
+
+    const int column = byteToColumn(line, byteColumn);
+    setSelection({line, column}, {line, column + term.size()});
+    ensureVisible({line, column});
+    return true;
+}
+
+QVector<LogView::Position> LogView::findAll(const QString &term, const Position &after) const
+{
+    QVector<Position> out;
+    const QByteArray needle = term.toUtf8();
+    if (needle.isEmpty() || needle.contains('\n'))
+        return out;
+    // Back up by the term length so a match crossing the position is found
+    const int from = qMax(0, columnToByte(after.line, after.column) - needle.size() + 1);
+    store_.forEachMatch(needle, after.line, from, [&](quint64 line, int byteColumn) {
+        out.append({line, byteToColumn(line, byteColumn)});
+    });
+    return out;
+}
@@ -20,8 +20,18 @@
 #include <QDialog>
 #include <QPlainTextEdit>
 #include <QKeyEvent>
+#include <QCloseEvent>
 #include <QThread>
-#include <QRandomGenerator>
+#include <QSpinBox>
+#include <QProgressBar>
+#include <QInputDialog>
+#include <QStatusBar>
+#include <QFileInfo>
+#include <cstring>
+#include <algorithm>
+#include <limits>
+#include <map>
+#include <QListWidget>
 
 // Implementation of CommandLineEdit with arrow key support
 CommandLineEdit::CommandLineEdit(QWidget *parent)
@@ -115,11 +125,31 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent)
     settingsMenu->addAction(highlightSettingsAction);
     connect(highlightSettingsAction, &QAction::triggered, this, &MainWindow::openHighlightRules);
 
+    // Tools menu: pty traffic generator
+    QMenu *toolsMenu = menuBar()->addMenu(tr("&Tools"));
+    QAction *generatorAction = new QAction(tr("Traffic Generator..."), this);
+    QAction *stopGeneratorAction = new QAction(tr("Stop Traffic Generator"), this);
+    toolsMenu->addAction(generatorAction);
+    toolsMenu->addAction(stopGeneratorAction);
+    connect(generatorAction, &QAction::triggered, this, &MainWindow::openTrafficGenerator);
+    connect(stopGeneratorAction, &QAction::triggered, this, [this]() { stopTrafficGenerator(); });
+    toolsMenu->addSeparator();
+    QAction *replayAction = new QAction(tr("Replay Capture..."), this);
+    QAction *stopReplayAction = new QAction(tr("Stop Replay"), this);
+    toolsMenu->addAction(replayAction);
+    toolsMenu->addAction(stopReplayAction);
+    connect(replayAction, &QAction::triggered, this, &MainWindow::openReplay);
+    connect(stopReplayAction, &QAction::triggered, this, [this]() {
+        if (replay_)
+            replay_->stop();
+    });
+
     // Build UI in separate function to keep constructor short
     setupUi();
 
-    // Create highlighter bound to the log view's document
-    highlighter_ = new LogHighlighter(logView_->document());
+    // Create highlighter; the log view asks it for formats of the lines it paints
+    highlighter_ = new LogHighlighter(this);
+    logView_->setHighlighter(highlighter_);
 
     // Load quick group labels and update the group boxes
     loadQuickGroupLabels();
@@ -128,6 +158,7 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent)
     if (quickGroup2Box_)
         quickGroup2Box_->setTitle(quickGroup2Label_);
 
+    connect(openAction, &QAction::triggered, this, &MainWindow::openFile);
     connect(saveAction, &QAction::triggered, this, &MainWindow::saveFile);
     connect(clearLogsAction, &QAction::triggered, this, &MainWindow::clearLogs);
     connect(exitAction, &QAction::triggered, this, &MainWindow::exitApp);
@@ -139,13 +170,60 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent)
     if (autoScrollCheck_) {
         autoScrollCheck_->setChecked(autoScrollEnabled_);
     }
+    logView_->setAutoScroll(autoScrollEnabled_);
+    applyScrollbackSettings();
+    applyLogWriterSettings();
+    applyCaptureSettings();
+
+    // Merged multi-port timeline is flushed on the RX frame clock
+    mergeTimer_ = new QTimer(this);
+    mergeTimer_->setTimerType(Qt::PreciseTimer);
+    mergeTimer_->setInterval(rxFrameIntervalMs_);
+    connect(mergeTimer_, &QTimer::timeout, this, [this]() { flushTimeline(false); });
+
+    // Log appends are committed to the view on the same frame clock
+    logFlushTimer_ = new QTimer(this);
+    logFlushTimer_->setTimerType(Qt::PreciseTimer);
+    logFlushTimer_->setSingleShot(true);
+    logFlushTimer_->setInterval(rxFrameIntervalMs_);
+    connect(logFlushTimer_, &QTimer::timeout, this, &MainWindow::flushLog);
+
+    // Full-log search runs on a thread pool; matches arrive in text order
+    search_ = new BackgroundSearch(this);
+    connect(search_, &BackgroundSearch::matchesFound, this, [this](const QVector<LogView::Position> &matches) {
+        searchMatches_ += matches;
+    });
+    connect(search_, &BackgroundSearch::progress, this, &MainWindow::updateSearchCountLabel);
+    connect(search_, &BackgroundSearch::finished, this, &MainWindow::onBackgroundSearchFinished);
 
-    // Create worker AFTER UI is setup
-    worker_ = new SerialWorker(this); // parent = this, no manual delete needed
+    // Opened files are indexed in the background
+    connect(logView_, &LogView::loadProgress, this, &MainWindow::onLogLoadProgress);
+    connect(logView_, &LogView::loadFinished, this, &MainWindow::onLogLoaded);
+    connect(logView_, &LogView::loadCancelled, this, &MainWindow::onLogLoadCancelled);
 
     // Setup command completer from history
     updateCommandCompleter();
-    connect(timer_, &QTimer::timeout, this, &MainWindow::timerHandler);
+
+    // RX hand-off statistics in the status bar, refreshed by timer_
+    rxStatsLabel_ = new QLabel(this);
+    statusBar()->addPermanentWidget(rxStatsLabel_);
+    timer_->start();
+
+    // Saving runs in the background; progress and cancel sit in the status bar
+    exporter_ = new LogExporter(this);
+    exportProgress_ = new QProgressBar(this);
+    exportProgress_->setMaximumWidth(160);
+    exportProgress_->setRange(0, 1000);
+    exportProgress_->hide();
+    exportCancelBtn_ = new QPushButton(tr("Cancel save"), this);
+    exportCancelBtn_->hide();
+    statusBar()->addPermanentWidget(exportProgress_);
+    statusBar()->addPermanentWidget(exportCancelBtn_);
+    connect(exportCancelBtn_, &QPushButton::clicked, exporter_, &LogExporter::cancel);
+    connect(exporter_, &LogExporter::progress, this, [this](qint64 done, qint64 total) {
+        exportProgress_->setValue(total > 0 ? int(done * 1000 / total) : 1000);
+    });
+    connect(exporter_, &LogExporter::finished, this, &MainWindow::onExportFinished);
 
     // View menu: Show / Close Plot
     connect(showPlotAction, &QAction::triggered, this, &MainWindow::onShowPlotTriggered);
@@ -154,10 +232,6 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent)
             plotWindow_->close();
     });
 
-    // Serial worker signals
-    connect(worker_, &SerialWorker::dataReceived, this, &MainWindow::onDataReceived);
-    connect(worker_, &SerialWorker::errorOccurred, this, &MainWindow::onError);
-
     closeBtn_->setEnabled(false);
     updatePortList();
     initFlag_ = true;
@@ -165,6 +239,13 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent)
 
 MainWindow::~MainWindow()
 {
+    // The batch thread may still be sending through a worker
+    batch_->cancel();
+    delete generator_;
+    capture_.close();
+    // Workers are children of this window; only the session records are ours
+    qDeleteAll(sessions_);
+    qDeleteAll(replaySessions_);
 }
 
 void MainWindow::updatePortList()
@@ -176,35 +257,137 @@ void MainWindow::updatePortList()
 
 void MainWindow::openSerial()
 {
-    if (!worker_) {
-        QMessageBox::critical(this, "Error", "Serial worker not initialized");
-        return;
-    }
-
     QString port = portCombo_->currentText();
     if (port.isEmpty()) {
         QMessageBox::warning(this, "Warning", "No serial port selected!");
         return;
     }
 
-    int baud = baudCombo_->currentData().toInt();
-    if (worker_->openPort(port, baud)) {
-        log("Opened " + port + " at " + QString::number(baud) + " baud.");
-        openBtn_->setEnabled(false);
-        closeBtn_->setEnabled(true);
+    int baud = baudCombo_->currentText().toInt();
+    if (baud <= 0) {
+        QMessageBox::warning(this, "Warning", "Invalid baud rate!");
+        return;
+    }
 
-        // Clear log, buffer and plot, serial buffer
-        // clearLog();
-        worker_->clearBuffer();
+    openPortSession(port, baud);
+}
+
+PortSession *MainWindow::openPortSession(const QString &port, int baud)
+{
+    if (findSession(port)) {
+        QMessageBox::warning(this, "Warning", port + " is already open!");
+        return nullptr;
+    }
+
+    // Each port gets its own worker, i.e. its own I/O thread and RX ring
+    PortSession *session = new PortSession;
+    session->name = port;
+    session->worker = new SerialWorker(this);
+    session->framer.reset(Framer::create(rxFraming_));
+    connect(session->worker, &SerialWorker::dataReceived, this, [this, session](const RxChunk &chunk) {
+        onSessionData(session, chunk);
+    });
+    connect(session->worker, &SerialWorker::errorOccurred, this, &MainWindow::onError);
+
+    SerialWorker::PortSettings settings;
+    settings.baudRate = baud;
+    settings.hardwareFlowControl = rtsCtsCheck_->isChecked();
+    settings.throughputMode = throughputMode_;
+    if (nativeBackend_) {
+        NativeSerialPort::Options opts;
+        opts.vmin = nativeVmin_;
+        opts.vtime = nativeVtime_;
+        opts.lowLatency = nativeLowLatency_;
+        session->worker->setNativeOptions(opts);
+        settings.backend = SerialWorker::Backend::NativeLinux;
+    }
+    if (!session->worker->openPort(port, settings)) {
+        delete session->worker;
+        delete session;
+        return nullptr;
     }
+
+    if (sessions_.size() + replaySessions_.size() == 1)
+        startMergedLog(port);
+    sessions_.append(session);
+    session->item = new QListWidgetItem(port, sessionList_);
+    session->item->setFlags(session->item->flags() | Qt::ItemIsUserCheckable);
+    session->item->setCheckState(Qt::Checked);
+    sessionList_->setCurrentItem(session->item);
+    setActiveSession(session);
+    applyRxDeliverySettings();
+
+    QString how;
+    if (nativeBackend_)
+        how = session->worker->lowLatencyActive() ? " (native, low latency)" : " (native)";
+    log("Opened " + port + " at " + QString::number(baud) + " baud" + how + ".");
+    closeBtn_->setEnabled(true);
+
+    // Clear log, buffer and plot, serial buffer
+    // clearLog();
+    session->worker->clearBuffer();
+    return session;
 }
 
 void MainWindow::closeSerial()
 {
-    worker_->closePort();
-    log("Closed port.");
-    openBtn_->setEnabled(true);
-    closeBtn_->setEnabled(false);
+    closeSession(activeSession_);
+}
+
+void MainWindow::closeSession(PortSession *session)
+{
+    if (!session)
+        return;
+
+    // Emit lines still waiting in the timeline before the session goes away
+    flushTimeline(true);
+
+    // A running batch script must not outlive the worker it sends through
+    if (batch_->worker() == session->worker)
+        batch_->cancel();
+
+    const bool wasActive = session == activeSession_;
+    session->worker->closePort();
+    log("Closed " + session->name + ".");
+    sessions_.removeOne(session);
+    delete session->item;
+    delete session->worker;
+    delete session;
+
+    if (wasActive) {
+        setActiveSession(sessions_.isEmpty() ? nullptr : sessions_.last());
+        if (activeSession_)
+            sessionList_->setCurrentItem(activeSession_->item);
+    }
+    closeBtn_->setEnabled(!sessions_.isEmpty());
+}
+
+PortSession *MainWindow::findSession(const QString &name) const
+{
+    for (PortSession *s : sessions_) {
+        if (s->name == name)
+            return s;
+    }
+    return nullptr;
+}
+
+void MainWindow::setActiveSession(PortSession *session)
+{
+    activeSession_ = session;
+    worker_ = session ? session->worker : nullptr;
+}
+
+QByteArray MainWindow::encodeCommand(const QString &cmd, bool hex) const
+{
+    if (!hex)
+        return cmd.toUtf8();
+
+    // parse input string as hex
+    QByteArray bytes;
+    QStringList parts = cmd.split(' ', Qt::SkipEmptyParts);
+    for (const QString &p : parts)
+        bytes.append(static_cast<char>(p.toUInt(nullptr, 16)));
+    return bytes;
 }
 
 void MainWindow::sendCommand()
@@ -222,18 +405,13 @@ void MainWindow::sendCommand()
     addCommandToHistory(cmd);
     cmd.append(eolMode_);
 
-    if (sendHex_->isChecked()) {
-        // parse input string as hex
-        QByteArray bytes;
-        QStringList parts = cmd.split(' ', Qt::SkipEmptyParts);
-        for (const QString &p : parts)
-            bytes.append(static_cast<char>(p.toUInt(nullptr, 16)));
-        worker_->sendData(bytes);
-        log("TX (HEX): " + cmd);
-    } else {
-        worker_->sendData(cmd.toUtf8());
-        log("TX: " + cmd);
+    const QByteArray bytes = encodeCommand(cmd, sendHex_->isChecked());
+    if (!worker_->sendData(bytes)) {
+        log("TX queue full, command dropped: " + cmd);
+        return;
     }
+    captureTx(worker_, SerialWorker::monotonicNs(), bytes);
+    log((sendHex_->isChecked() ? "TX (HEX): " : "TX: ") + cmd);
 }
 
 void MainWindow::sendAllCommands()
@@ -243,7 +421,7 @@ void MainWindow::sendAllCommands()
         return;
     }
 
-    if (!cmdListView_)
+    if (!cmdListView_ || batch_->isRunning())
         return;
 
     QString content = cmdListView_->toPlainText();
@@ -256,15 +434,21 @@ void MainWindow::sendAllCommands()
     QRegularExpression reRandDelay(R"(^\s*rand_delay\(\s*([0-9]+)\s*,\s*([0-9]+)\s*\)\s*$)", QRegularExpression::CaseInsensitiveOption);
     QRegularExpression reComment(R"(^\s*comment\(.*\)\s*$)", QRegularExpression::CaseInsensitiveOption);
 
+    // Parse and encode the whole script up front; BatchScheduler only has to
+    // wait for deadlines and queue bytes.
+    QVector<BatchStep> steps;
     for (const QString &raw : lines) {
         QString cmd = raw.trimmed();
         if (cmd.isEmpty())
             continue;
 
+        BatchStep step;
+
         // Check for comment lines (start with # or comment(...))
         if (cmd.startsWith('#') || reComment.match(cmd).hasMatch()) {
-            // Log comment (optional, for debugging)
-            log(QString("# %1\n").arg(cmd));
+            step.kind = BatchStep::Comment;
+            step.text = cmd;
+            steps.append(step);
             continue;
         }
 
@@ -272,10 +456,10 @@ void MainWindow::sendAllCommands()
         QRegularExpressionMatch m = reDelaySec.match(cmd);
         if (m.hasMatch()) {
             double secs = m.captured(1).toDouble();
-            log(QString("Delay %1 s\n").arg(secs));
-            unsigned long ms = static_cast<unsigned long>(secs * 1000.0);
-            if (ms > 0)
-                QThread::msleep(ms);
+            step.kind = BatchStep::Delay;
+            step.text = QString("Delay %1 s").arg(secs);
+            step.delayMs = secs * 1000.0;
+            steps.append(step);
             continue;
         }
 
@@ -283,98 +467,213 @@ void MainWindow::sendAllCommands()
         m = reDelayMs.match(cmd);
         if (m.hasMatch()) {
             unsigned long ms = m.captured(1).toULong();
-            log(QString("Delay %1 ms\n").arg(ms));
-            if (ms > 0)
-                QThread::msleep(ms);
+            step.kind = BatchStep::Delay;
+            step.text = QString("Delay %1 ms").arg(ms);
+            step.delayMs = double(ms);
+            steps.append(step);
             continue;
         }
 
-        // Check for "rand_delay(min_ms, max_ms)" special command
+        // Check for "rand_delay(min_ms, max_ms)" special command; the value
+        // is drawn when the step runs
         m = reRandDelay.match(cmd);
         if (m.hasMatch()) {
             quint32 minMs = m.captured(1).toUInt();
             quint32 maxMs = m.captured(2).toUInt();
             if (minMs > maxMs)
                 std::swap(minMs, maxMs);
-            quint32 delayMs = QRandomGenerator::global()->bounded(minMs, maxMs + 1);
-            log(QString("Random Delay %1 ms (range %2-%3 ms)\n").arg(delayMs).arg(minMs).arg(maxMs));
-            if (delayMs > 0)
-                QThread::msleep(delayMs);
+            step.kind = BatchStep::RandomDelay;
+            step.minMs = minMs;
+            step.maxMs = maxMs;
+            steps.append(step);
             continue;
         }
 
-        // Normal command: set text and reuse sendCommand() for EOL/HEX handling
-        commandLine_->setText(cmd);
-        sendCommand();
+        // Normal command: same EOL/HEX handling as sendCommand()
+        addCommandToHistory(cmd);
+        cmd.append(eolMode_);
+        step.kind = BatchStep::Send;
+        step.text = cmd;
+        step.payload = encodeCommand(cmd, sendHex_->isChecked());
+        steps.append(step);
     }
+    if (steps.isEmpty())
+        return;
+
+    batchHex_ = sendHex_->isChecked();
+    batchProgress_->setRange(0, steps.size());
+    batchProgress_->setValue(0);
+    batchProgress_->show();
+    batchPauseBtn_->setText(tr("Pause"));
+    batchPauseBtn_->setEnabled(true);
+    batchCancelBtn_->setEnabled(true);
+    sendAllBtn_->setEnabled(false);
+    batch_->start(worker_, steps);
 }
 
-void MainWindow::onDataReceived(const QByteArray &data)
+void MainWindow::onBatchFinished(bool cancelled, int sent, double meanJitterUs, double maxJitterUs)
 {
-    if (initFlag_) {
+    log(QString("Batch %1: %2 command(s) sent, timing jitter mean %3 us, max %4 us\n")
+            .arg(cancelled ? "stopped" : "done")
+            .arg(sent)
+            .arg(meanJitterUs, 0, 'f', 1)
+            .arg(maxJitterUs, 0, 'f', 1));
+    batchProgress_->hide();
+    batchPauseBtn_->setEnabled(false);
+    batchCancelBtn_->setEnabled(false);
+    sendAllBtn_->setEnabled(true);
+}
+
+void MainWindow::onSessionData(PortSession *session, const RxChunk &chunk)
+{
+    const bool multi = sessions_.size() + replaySessions_.size() > 1;
+    if (initFlag_ && !multi) {
         initFlag_ = false;
         return;
     }
 
-    if (hexCheck_->isChecked()) {
-        QString hex = data.toHex(' ').toUpper();
-        log(hex);
-    } else {
-        QString strLine = QString::fromUtf8(data);
-        log(strLine);
+    const char *data = chunk.data();
+    const int size = chunk.size();
+    const bool hex = hexCheck_->isChecked();
+    if (capture_.isOpen() && session->worker)
+        capture_.append(Capture::Direction::Rx, capture_.portId(session->name), chunk.timestampNs(), data, size);
+
+    // Single port: log the raw chunk as it arrives
+    if (!multi) {
+        if (hex) {
+            const QByteArray hexStr = chunk.bytes().toHex(' ').toUpper();
+            logUtf8(hexStr.constData(), hexStr.size());
+        } else {
+            // Raw bytes go straight to the store; a character split across
+            // chunks is joined again there
+            logUtf8(data, size);
+        }
     }
 
-    // Handle data string for
-    buffer_.append(data);
+    // Frames are views into the chunk wherever possible; the framer only
+    // copies an incomplete frame at the end to wait for the rest. With
+    // several ports open, complete frames go to the merged timeline.
+    const QString keyPrefix = multi ? session->name + "/" : QString();
+    session->framer->feed(data, size, [&](const FrameView &frame) {
+        if (multi) {
+            // The start of a line cut off by the second port opening is in
+            // the log already
+            const int skip = qMin(session->loggedPartial, frame.size);
+            session->loggedPartial = 0;
+            QString text;
+            if (hex) {
+                text = QByteArray::fromRawData(frame.data + skip, frame.size - skip).toHex(' ').toUpper() + '\n';
+            } else {
+                text = QString::fromUtf8(frame.data + skip, frame.size - skip);
+                if (frame.delimiter != '\n')
+                    text.append('\n');
+            }
+            timeline_.append({chunk.timestampNs(), timelineSeq_++, session, text});
+        }
+        // Telemetry is lines: not ETX frames, and not frames cut at the size
+        // limit (delimiter -1), which would plot a partial record
+        if (!hex && frame.delimiter == '\n')
+            onDataPlotter(frame.data, frame.size, keyPrefix);
+    });
 
-    QByteArray line;
-    int splitIndex = -1;
+    if (multi && !timeline_.isEmpty() && !mergeTimer_->isActive())
+        mergeTimer_->start();
+}
 
-    // HEX MODE: tách theo 0x0A hoặc 0xDD
-    while (true) {
-        int idxLF = buffer_.indexOf(char(0x0A));  // '\n'
-        int idxETX = buffer_.indexOf(char(0xDD)); // ETX
-        if (idxLF == -1 && idxETX == -1)
-            break;
+void MainWindow::startMergedLog(const QString &addedPort)
+{
+    // The first port was logged raw and untagged, including the start of
+    // the line it is in the middle of. End that line here and mark what came
+    // before; the framer still completes the line for the plotter, and its
+    // logged start is left out of the merged log (see onSessionData).
+    PortSession *first = sessions_.isEmpty() ? replaySessions_.first() : sessions_.first();
+    first->loggedPartial = first->framer->pendingSize();
+    log(QString("%1--- %2 opened; lines above are from %3 ---\n")
+            .arg(logLineOpen() ? QString("\n") : QString(), addedPort, first->name));
+}
 
-        if (idxLF == -1)
-            splitIndex = idxETX;
-        else if (idxETX == -1)
-            splitIndex = idxLF;
-        else
-            splitIndex = std::min(idxLF, idxETX);
+bool MainWindow::logLineOpen() const
+{
+    return pendingLog_.isEmpty() ? logView_->store().openLine() : !pendingLog_.endsWith('\n');
+}
 
-        line = buffer_.left(splitIndex + 1);
-        buffer_.remove(0, splitIndex + 1);
+void MainWindow::addNote()
+{
+    bool ok = false;
+    const QString text = QInputDialog::getText(this, tr("Add Note"), tr("Note:"), QLineEdit::Normal,
+                                               QString(), &ok).simplified();
+    if (!ok || text.isEmpty())
+        return;
+    log(QString("%1--- NOTE %2: %3 ---\n")
+            .arg(logLineOpen() ? QString("\n") : QString(),
+                 QDateTime::currentDateTime().toString("hh:mm:ss.zzz"), text));
+}
 
-        if (hexCheck_->isChecked()) {
-            // QString hex = line.toHex(' ').toUpper();
-            // log("RX: " + hex);
-        } else {
-            QString strLine = QString::fromUtf8(line);
-            if (line.endsWith('\n')) {
-                onDataPlotter(strLine);
-            }
-        }
+void MainWindow::flushTimeline(bool all)
+{
+    if (timeline_.isEmpty()) {
+        mergeTimer_->stop();
+        return;
+    }
+
+    // Lines younger than the reorder window wait, in case another port still
+    // has older data in flight
+    const qint64 windowNs = qint64(qMax(20, 2 * rxFrameIntervalMs_)) * 1000000;
+    const qint64 cutoff = all ? std::numeric_limits<qint64>::max()
+                              : SerialWorker::monotonicNs() - windowNs;
+
+    std::sort(timeline_.begin(), timeline_.end(), [](const TimelineLine &a, const TimelineLine &b) {
+        return a.timestampNs != b.timestampNs ? a.timestampNs < b.timestampNs : a.seq < b.seq;
+    });
+
+    int count = 0;
+    QString out;
+    for (; count < timeline_.size(); ++count) {
+        const TimelineLine &l = timeline_[count];
+        if (l.timestampNs > cutoff)
+            break;
+        out += '[' + l.session->name + "] " + l.text;
+    }
+    if (count > 0) {
+        // Lines of ports that are filtered out are hidden by the view
+        log(out);
+        timeline_.remove(0, count);
+    }
+    if (timeline_.isEmpty())
+        mergeTimer_->stop();
+}
+
+void MainWindow::applyLogFilter()
+{
+    QVector<QByteArray> hiddenTags;
+    for (const PortSession *s : sessions_) {
+        if (!s->shown)
+            hiddenTags.append(('[' + s->name + "] ").toUtf8());
     }
+    logView_->setHiddenPrefixes(hiddenTags);
 }
 
-void MainWindow::onDataPlotter(const QString &line)
+void MainWindow::onDataPlotter(const char *line, int size, const QString &keyPrefix)
 {
     // Parse as Arduino type: "sensor1:23.5,sensor2:45.6,sensor3:78.9\n"
+    // Works on the raw bytes, so lines without ':' cost nothing.
+    if (!memchr(line, ':', size))
+        return;
+
     QMap<QString, double> values;
-    QStringList parts = line.split(',', Qt::SkipEmptyParts);
-    for (const QString &part : parts) {
-        // qDebug() << part << "\n";
-        // Check for key:value format
-        if (part.count(':') != 1)
-            continue;
-        QStringList kv = part.split(':');
-        if (kv.size() == 2) {
-            QString key = kv[0];
-            double val = kv[1].toDouble();
+    const char *p = line;
+    const char *end = p + size;
+    while (p < end) {
+        const char *comma = static_cast<const char *>(memchr(p, ',', end - p));
+        const char *partEnd = comma ? comma : end;
+        // Check for key:value format (exactly one ':')
+        const char *colon = static_cast<const char *>(memchr(p, ':', partEnd - p));
+        if (colon && !memchr(colon + 1, ':', partEnd - colon - 1)) {
+            QString key = keyPrefix + QString::fromUtf8(p, int(colon - p));
+            double val = QByteArray::fromRawData(colon + 1, int(partEnd - colon - 1)).toDouble();
             values[key] = val;
         }
+        p = partEnd + 1;
     }
     if (!values.isEmpty()) {
         emit newSerialData(values);
@@ -388,74 +687,86 @@ void MainWindow::onError(const QString &msg)
 
 void MainWindow::log(const QString &msg)
 {
-    // Save current scroll bar position
-    QScrollBar *vScrollBar = logView_->verticalScrollBar();
-    int currentScrollValue = vScrollBar->value();
-
-    // Get current cursor
-    QTextCursor cursor = logView_->textCursor();
-
-    // Save selection zone
-    bool hasSelection = cursor.hasSelection();
-    int selectionStart = cursor.selectionStart();
-    int selectionEnd = cursor.selectionEnd();
-
-    // Always move cursor to end before inserting new text
-    // This ensures new log entries are appended at the end, not at cursor position
-    cursor.movePosition(QTextCursor::End);
-    logView_->setTextCursor(cursor);
-    logView_->insertPlainText(msg);
-
-    // Auto scroll to end only if auto-scroll is enabled
-    if (autoScrollEnabled_) {
-        logView_->ensureCursorVisible();
-    } else {
-        // Recovery scroll bar
-        vScrollBar->setValue(currentScrollValue);
-        // Recovery selection zone
-        if (hasSelection) {
-            QTextCursor restoreCursor = logView_->textCursor();
+    const QByteArray utf8 = msg.toUtf8();
+    logUtf8(utf8.constData(), utf8.size());
+}
 
-            restoreCursor.setPosition(selectionStart);
-            restoreCursor.setPosition(selectionEnd, QTextCursor::KeepAnchor);
+void MainWindow::logUtf8(const char *data, int size)
+{
+    if (size <= 0)
+        return;
+    pendingLog_.append(data, size);
+    logWriter_.append(data, size);
+    ++logAppends_;
+    if (!logFlushTimer_->isActive())
+        logFlushTimer_->start();
+}
 
-            logView_->setTextCursor(restoreCursor);
+void MainWindow::flushLog()
+{
+    logFlushTimer_->stop();
+    // Nothing goes in while a file is being indexed; onLogLoaded() flushes
+    if (pendingLog_.isEmpty() || logView_->isLoading())
+        return;
+    // One append per frame. The view appends at the end and keeps the
+    // selection and, unless auto-scroll is on, the scroll position.
+    const LogView::Position oldEnd = logView_->endPosition();
+    logView_->appendUtf8(pendingLog_.constData(), pendingLog_.size());
+    vocabulary_.addUtf8(pendingLog_.constData(), pendingLog_.size());
+    pendingLog_.clear();
+    ++logCommits_;
+
+    // Extend the match list with what the append completed; the view
+    // highlights new matches by itself when it repaints. A running
+    // background search picks up the appended text when it finishes.
+    const QString term = searchLine_->text();
+    if (!term.isEmpty()) {
+        if (term == searchMatchesTerm_) {
+            if (search_->isRunning())
+                return;
+            searchMatches_ += logView_->findAll(term, oldEnd);
+        } else {
+            highlightSearchResults(term);
+            updateSearchMatches(term);
         }
-    }
-
-    // Update search highlights if search term is not empty
-    if (!searchLine_->text().isEmpty()) {
-        highlightSearchResults(searchLine_->text());
-        updateSearchMatches(searchLine_->text());
         updateSearchCountLabel();
     }
 }
 
 void MainWindow::clearLog()
 {
-    // If there's content, save it into ./log with default filename before clearing
-    QString contents = logView_->toPlainText();
-    if (!contents.isEmpty()) {
-        QDir d(QDir::currentPath());
-        if (!d.exists("log")) {
-            d.mkdir("log");
-        }
-        QString defaultName = QDateTime::currentDateTime().toString("yyMMdd_hhmmss");
-        QString filePath = d.filePath(QString("log/log_%1.txt").arg(defaultName));
-        QFile file(filePath);
-        if (file.open(QIODevice::WriteOnly | QIODevice::Text)) {
-            QTextStream out(&file);
-            out << contents;
-            file.close();
-        }
-    }
+    stopCaptureLoad();
+    // While a file is indexed flushLog() holds live lines back. The file is
+    // on disk already; stop the scan so those lines go through like any other.
+    if (logView_->isLoading())
+        logView_->clear();
+    flushLog();
+    // With LogToDisk the text is on disk already and what follows goes to a
+    // new file; without it the text is saved to log/ before it goes
+    if (logToDisk_)
+        logWriter_.rotate();
+    else
+        saveClearedLog();
 
     logView_->clear();
-    buffer_.clear();
+    vocabulary_.clear();
+    vocabularyFed_ = 0;
+    scrollbackErrorShown_ = false;
+    for (PortSession *session : sessions_) {
+        session->framer->reset();
+        session->loggedPartial = 0;
+    }
+    for (PortSession *session : replaySessions_) {
+        session->framer->reset();
+        session->loggedPartial = 0;
+    }
+    timeline_.clear();
     emit clearData();
     initFlag_ = true;
 
     // Reset search state
+    search_->cancel();
+    searchNotFoundPending_ = false;
     searchMatches_.clear();
     currentSearchIndex_ = -1;
     lastSearchTerm_.clear();
@@ -465,20 +776,42 @@ void MainWindow::clearLog()
 void MainWindow::openFile()
 {
     QString path = QFileDialog::getOpenFileName(this, tr("Open Log File"), QString(),
-                                                tr("Text Files (*.txt);;All Files (*)"));
+                                                tr("Text Files (*.txt);;Captures (*.sgcap);;All Files (*)"));
     if (path.isEmpty())
         return;
+    if (CaptureReader::isCapture(path)) {
+        openCapture(path);
+        return;
+    }
 
     QFile file(path);
-    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+    if (!file.open(QIODevice::ReadOnly)) {
         QMessageBox::warning(this, tr("Open Failed"), tr("Unable to open file: %1").arg(path));
         return;
     }
-    QTextStream in(&file);
-    QString contents = in.readAll();
-    file.close();
+    stopCaptureLoad();
+    flushLog();
+    search_->cancel();
+    searchMatches_.clear();
+    currentSearchIndex_ = -1;
+    vocabulary_.clear();
+    vocabularyFed_ = 0;
+    // Shown in place and indexed in the background; the match list is
+    // built once the whole file is indexed (see onLogLoaded)
+    if (logView_->openMapped(path)) {
+        file.close();
+        updateCompleter();
+        updateSearchCountLabel();
+        return;
+    }
 
-    logView_->setPlainText(contents);
+    // Cannot be mapped: read in blocks straight into the line store
+    QByteArray block;
+    while (!(block = file.read(LogLineStore::kChunkSize)).isEmpty()) {
+        logView_->appendUtf8(block.constData(), block.size());
+        vocabulary_.addUtf8(block.constData(), block.size());
+    }
+    file.close();
     // refresh completer and highlights
     updateCompleter();
     highlightSearchResults(searchLine_->text());
@@ -487,8 +820,207 @@ void MainWindow::openFile()
     updateSearchCountLabel();
 }
 
+void MainWindow::onLogLoadProgress(qint64 bytesDone, qint64 bytesTotal)
+{
+    // The completer learns the words at the top of a mapped file only;
+    // tokenizing all of it here would undo the point of mapping it
+    const qint64 upTo = qMin(bytesDone, kMappedVocabularyBytes);
+    if (upTo > vocabularyFed_) {
+        vocabulary_.addUtf8(logView_->store().mappedData() + vocabularyFed_, int(upTo - vocabularyFed_));
+        vocabularyFed_ = upTo;
+    }
+    statusBar()->showMessage(tr("Indexing lines: %1%").arg(bytesTotal > 0 ? bytesDone * 100 / bytesTotal : 100));
+}
+
+void MainWindow::onLogLoaded()
+{
+    statusBar()->clearMessage();
+    // Lines logged meanwhile were held back by flushLog()
+    flushLog();
+    updateCompleter();
+    updateSearchMatches(searchLine_->text());
+}
+
+void MainWindow::onLogLoadCancelled()
+{
+    statusBar()->clearMessage();
+}
+
+void MainWindow::captureTx(const SerialWorker *worker, qint64 timestampNs, const QByteArray &bytes)
+{
+    if (!capture_.isOpen())
+        return;
+    for (const PortSession *session : sessions_) {
+        if (session->worker == worker) {
+            capture_.append(Capture::Direction::Tx, capture_.portId(session->name), timestampNs, bytes.constData(),
+                            bytes.size());
+            return;
+        }
+    }
+}
+
+struct MainWindow::CaptureLoad
+{
+    CaptureReader reader;
+    QString path;
+    bool hex = false;
+    // Decoded the way onSessionData() shows live traffic, one framer per port
+    std::map<int, std::unique_ptr<Framer>> framers;
+    int nextBlock = 0;
+    int damaged = 0;
+};
+
+void MainWindow::openCapture(const QString &path)
+{
+    auto load = std::make_shared<CaptureLoad>();
+    if (!load->reader.open(path)) {
+        QMessageBox::warning(this, tr("Open Failed"), load->reader.errorString());
+        return;
+    }
+    // A capture is shown like a fresh session: log and plot start over
+    clearLog();
+
+    load->path = path;
+    load->hex = hexCheck_->isChecked();
+    captureLoad_ = load;
+    if (!captureLoadTimer_) {
+        captureLoadTimer_ = new QTimer(this);
+        connect(captureLoadTimer_, &QTimer::timeout, this, &MainWindow::loadCaptureSlice);
+    }
+    captureLoadTimer_->start(0);
+}
+
+void MainWindow::loadCaptureSlice()
+{
+    if (!captureLoad_)
+        return;
+    CaptureLoad &load = *captureLoad_;
+    const qint64 sliceEnd = SerialWorker::monotonicNs() + qint64(CaptureReplay::kSliceMs) * 1000000;
+    QVector<Capture::Record> records;
+    QByteArray text;
+    while (load.nextBlock < load.reader.blockCount() && SerialWorker::monotonicNs() < sliceEnd) {
+        if (!load.reader.readBlock(load.nextBlock++, records)) {
+            ++load.damaged;
+            continue;
+        }
+        // Every block names the ports recorded so far
+        const QStringList ports = load.reader.portNames();
+        const bool multi = ports.size() > 1;
+        for (const Capture::Record &r : records) {
+            if (r.direction == Capture::Direction::PortName)
+                continue;
+            const QString name = ports.value(r.port);
+            const QByteArray tag = multi ? ('[' + name + "] ").toUtf8() : QByteArray();
+            if (r.direction == Capture::Direction::Tx) {
+                text += tag + (load.hex ? "TX (HEX): " + r.data.toHex(' ').toUpper() : "TX: " + r.data);
+                if (!text.endsWith('\n'))
+                    text += '\n';
+                continue;
+            }
+
+            if (!multi)
+                text += load.hex ? r.data.toHex(' ').toUpper() : r.data;
+            std::unique_ptr<Framer> &framer = load.framers[r.port];
+            if (!framer)
+                framer.reset(Framer::create(rxFraming_));
+            const QString keyPrefix = multi ? name + "/" : QString();
+            framer->feed(r.data.constData(), r.data.size(), [&](const FrameView &frame) {
+                if (multi) {
+                    text += tag;
+                    if (load.hex) {
+                        text += QByteArray::fromRawData(frame.data, frame.size).toHex(' ').toUpper() + '\n';
+                    } else {
+                        text.append(frame.data, frame.size);
+                        if (frame.delimiter != '\n')
+                            text += '\n';
+                    }
+                }
+                if (!load.hex && frame.delimiter == '\n')
+                    onDataPlotter(frame.data, frame.size, keyPrefix);
+            });
+        }
+    }
+    // Lines logged meanwhile go in first
+    flushLog();
+    logView_->appendUtf8(text.constData(), text.size());
+    vocabulary_.addUtf8(text.constData(), text.size());
+
+    const int blocks = load.reader.blockCount();
+    if (load.nextBlock < blocks) {
+        const quint64 done = load.reader.block(load.nextBlock).firstByte;
+        const quint64 total = qMax<quint64>(1, load.reader.payloadBytes());
+        statusBar()->showMessage(tr("Decoding %1: %2%").arg(QFileInfo(load.path).fileName()).arg(done * 100 / total));
+        return;
+    }
+
+    // Done: keep the state alive until the messages are out
+    const std::shared_ptr<CaptureLoad> keep = captureLoad_;
+    stopCaptureLoad();
+    updateCompleter();
+    highlightSearchResults(searchLine_->text());
+    updateSearchMatches(searchLine_->text());
+    currentSearchIndex_ = -1;
+    updateSearchCountLabel();
+    statusBar()->showMessage(tr("%1: %2 bytes in %3 block(s)").arg(QFileInfo(keep->path).fileName())
+                                 .arg(keep->reader.payloadBytes()).arg(blocks));
+    if (keep->damaged > 0)
+        log(QString("%1 damaged block(s) of %2 skipped\n").arg(keep->damaged).arg(keep->path));
+}
+
+void MainWindow::saveClearedLog()
+{
+    if (logView_->store().isEmpty())
+        return;
+    QDir dir(QDir::currentPath());
+    if (!dir.exists("log"))
+        dir.mkdir("log");
+
+    // A file still being written is not on disk under its name yet
+    const QList<LogExporter *> exporters = findChildren<LogExporter *>();
+    auto taken = [&exporters](const QString &path) {
+        if (QFileInfo::exists(path))
+            return true;
+        for (const LogExporter *exporter : exporters) {
+            if (exporter->isRunning() && exporter->fileName() == path)
+                return true;
+        }
+        return false;
+    };
+    const QString stamp = QDateTime::currentDateTime().toString("yyMMdd_hhmmss");
+    QString path = dir.filePath(QString("log/log_%1.txt").arg(stamp));
+    for (int n = 2; taken(path); ++n)
+        path = dir.filePath(QString("log/log_%1_%2.txt").arg(stamp).arg(n));
+
+    // An exporter of its own, so a save in progress does not stand in the
+    // way; it works from a snapshot and goes once the file is written
+    LogExporter *exporter = new LogExporter(this);
+    connect(exporter, &LogExporter::finished, this, [this, exporter](bool, const QString &error) {
+        if (!error.isEmpty())
+            QMessageBox::warning(this, tr("Save Failed"),
+                                 tr("Unable to save file: %1\n%2").arg(exporter->fileName(), error));
+        exporter->deleteLater();
+    });
+    exporter->start(logView_->store(), path);
+}
+
+void MainWindow::stopCaptureLoad()
+{
+    if (captureLoadTimer_)
+        captureLoadTimer_->stop();
+    captureLoad_.reset();
+}
+
 void MainWindow::saveFile()
 {
+    if (exporter_->isRunning()) {
+        QMessageBox::information(this, tr("Save Log File"), tr("Still saving %1").arg(exporter_->fileName()));
+        return;
+    }
+    if (logView_->isLoading()) {
+        QMessageBox::information(this, tr("Save Log File"), tr("The open file is still being indexed"));
+        return;
+    }
+
     // Suggest default filename: log_yymmdd_hhmmss.txt
     QString defaultName = QDateTime::currentDateTime().toString("yyMMdd_hhmmss");
     defaultName = QString("log_%1.txt").arg(defaultName);
@@ -497,41 +1029,61 @@ void MainWindow::saveFile()
     if (path.isEmpty())
         return;
 
-    QFile file(path);
-    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
-        QMessageBox::warning(this, tr("Save Failed"), tr("Unable to save file: %1").arg(path));
-        return;
-    }
-    QTextStream out(&file);
-    out << logView_->toPlainText();
-    file.close();
+    // The log as it is now; what arrives meanwhile is not part of the file
+    flushLog();
+    exporter_->start(logView_->store(), path);
+    exportProgress_->setValue(0);
+    exportProgress_->show();
+    exportCancelBtn_->show();
+}
+
+void MainWindow::onExportFinished(bool cancelled, const QString &error)
+{
+    exportProgress_->hide();
+    exportCancelBtn_->hide();
+    if (!error.isEmpty())
+        QMessageBox::warning(this, tr("Save Failed"),
+                             tr("Unable to save file: %1\n%2").arg(exporter_->fileName(), error));
+    else if (cancelled)
+        statusBar()->showMessage(tr("Save cancelled"), 3000);
+    else
+        statusBar()->showMessage(tr("Saved %1").arg(exporter_->fileName()), 3000);
 }
 
 void MainWindow::exitApp()
 {
-    // Auto-save log if option is enabled and there's content
-    if (autoSaveOnExit_) {
-        QString contents = logView_->toPlainText();
-        if (!contents.isEmpty()) {
-            QDir d(QDir::currentPath());
-            if (!d.exists("log")) {
-                d.mkdir("log");
-            }
-            QString defaultName = QDateTime::currentDateTime().toString("yyMMdd_hhmmss");
-            QString filePath = d.filePath(QString("log/log_%1.txt").arg(defaultName));
-            QFile file(filePath);
-            if (file.open(QIODevice::WriteOnly | QIODevice::Text)) {
-                QTextStream out(&file);
-                out << contents;
-                file.close();
-            }
+    close();
+}
+
+void MainWindow::closeEvent(QCloseEvent *event)
+{
+    // A save the user started is finished unless they say otherwise
+    if (exporter_->isRunning()) {
+        const QMessageBox::StandardButton reply = QMessageBox::question(
+            this, tr("Exit"), tr("Still saving %1.\nWait for it to finish?").arg(exporter_->fileName()),
+            QMessageBox::Yes | QMessageBox::No | QMessageBox::Cancel, QMessageBox::Yes);
+        if (reply == QMessageBox::Cancel) {
+            event->ignore();
+            return;
         }
+        if (reply == QMessageBox::No)
+            exporter_->cancel();
     }
 
+    // Write out what the disk log has buffered
+    flushLog();
+    logWriter_.stop();
+    capture_.close();
+    // A save in progress is finished, not dropped; so is a cleared log
+    // still being written out
+    for (LogExporter *exporter : findChildren<LogExporter *>())
+        exporter->waitForDone();
+
     // Close plot window if open, then quit
     if (plotWindow_) {
         plotWindow_->close();
     }
+    event->accept();
     qApp->quit();
 }
 
@@ -540,14 +1092,15 @@ void MainWindow::searchLog()
     QString text = searchLine_->text();
     if (text.isEmpty())
         return;
+    flushLog();
 
     // Default behavior: find next occurrence from current cursor
-    if (logView_->find(text, QTextDocument::FindCaseSensitively)) {
+    if (logView_->find(text)) {
         logView_->setFocus();
     } else {
         // wrap-around: try from top once
-        logView_->moveCursor(QTextCursor::Start);
-        if (logView_->find(text, QTextDocument::FindCaseSensitively)) {
+        logView_->moveCursorToStart();
+        if (logView_->find(text)) {
             logView_->setFocus();
         } else {
             showMessageAutoClose("Search", "Text not found!", 1500);
@@ -557,14 +1110,9 @@ void MainWindow::searchLog()
 
 void MainWindow::updateCompleter()
 {
-    QString allText = logView_->toPlainText();
-    QStringList words = allText.split(QRegExp("\\W+"), Qt::SkipEmptyParts);
-    words.removeDuplicates();
-
-    QCompleter *completer = new QCompleter(words, this);
-    completer->setCaseSensitivity(Qt::CaseInsensitive);
-    completer->setCompletionMode(QCompleter::PopupCompletion);
-    searchLine_->setCompleter(completer);
+    // The most frequent log words with the typed prefix; the index is kept
+    // up to date as text is appended, so this does not grow with the log
+    completionModel_->setStringList(vocabulary_.topMatches(searchLine_->text(), kCompletions));
 
     // Also update highlights for current search term
     highlightSearchResults(searchLine_->text());
@@ -572,65 +1120,92 @@ void MainWindow::updateCompleter()
 
 void MainWindow::highlightSearchResults(const QString &term)
 {
-    // Use extra selections so highlights are not permanent edits to the document
-    QList<QTextEdit::ExtraSelection> extras;
-    if (term.isEmpty()) {
-        logView_->setExtraSelections(extras);
-        return;
-    }
-
-    QTextDocument *doc = logView_->document();
-    QTextCursor cursor(doc);
-    QTextCharFormat fmt;
-    fmt.setBackground(searchHighlightColor_);
+    // The view marks matches in the lines it paints; nothing is stored per match
     // Keep text color consistent with log text color for readability
-    fmt.setForeground(logTextColor_);
-
-    while (true) {
-        cursor = doc->find(term, cursor);
-        if (cursor.isNull())
-            break;
-        QTextEdit::ExtraSelection sel;
-        sel.cursor = cursor;
-        sel.format = fmt;
-        extras.append(sel);
-    }
-    logView_->setExtraSelections(extras);
+    logView_->setSearchHighlight(term, searchHighlightColor_, logTextColor_);
 }
 
 void MainWindow::updateSearchMatches(const QString &term)
 {
     // Find all matches and update the list
     searchMatches_.clear();
+    searchMatchesTerm_ = term;
     currentSearchIndex_ = -1;
+    searchNotFoundPending_ = false;
 
     if (term.isEmpty()) {
+        search_->cancel();
         updateSearchCountLabel();
         return;
     }
 
-    QString allText = logView_->toPlainText();
-    int pos = 0;
-    while (true) {
-        int idx = allText.indexOf(term, pos, Qt::CaseSensitive);
-        if (idx == -1) break;
-        searchMatches_.append(idx);
-        pos = idx + term.length();
-    }
+    // Replaces any search for the previous term. Text appended meanwhile is
+    // searched from searchEnd_ when it finishes.
+    searchEnd_ = logView_->endPosition();
+    search_->start(logView_->store(), term);
 
     updateSearchCountLabel();
 }
 
+void MainWindow::onBackgroundSearchFinished()
+{
+    // While a file is loading the text is searched again once it is all there
+    if (!logView_->isLoading())
+        searchMatches_ += logView_->findAll(searchMatchesTerm_, searchEnd_);
+    if (currentSearchIndex_ < 0 && logView_->hasSelection()) {
+        const LogView::Position from = logView_->selectionStart();
+        auto it = std::lower_bound(searchMatches_.begin(), searchMatches_.end(), from);
+        if (it != searchMatches_.end() && *it == from)
+            currentSearchIndex_ = int(it - searchMatches_.begin());
+    }
+    if (searchNotFoundPending_ && searchMatches_.isEmpty()) {
+        showMessageAutoClose("Search", "Text not found!", 1500);
+        lastSearchTerm_.clear();
+    }
+    searchNotFoundPending_ = false;
+    updateSearchCountLabel();
+}
+
 void MainWindow::updateSearchCountLabel()
 {
-    if (searchMatches_.isEmpty() || lastSearchTerm_.isEmpty()) {
+    if ((searchMatches_.isEmpty() && !search_->isRunning()) || lastSearchTerm_.isEmpty()) {
         searchCountLabel_->setText("");
         return;
     }
 
     int total = searchMatches_.size();
     int current = (currentSearchIndex_ >= 0) ? (currentSearchIndex_ + 1) : 0;
-    searchCountLabel_->setText(QString("%1/%2").arg(current).arg(total));
+    QString text = QString("%1/%2").arg(current).arg(total);
+    // The total is still growing
+    if (search_->isRunning())
+        text += "...";
+    searchCountLabel_->setText(text);
+}
+
+void MainWindow::goToSearchMatch(int index)
+{
+    const LogView::Position pos = searchMatches_[index];
+    logView_->setSelection(pos, {pos.line, pos.column + searchMatchesTerm_.size()});
+    logView_->ensureVisible(pos);
+    currentSearchIndex_ = index;
+}
+
+bool MainWindow::findFromCursor(const QString &term, bool backward)
+{
+    if (!logView_->find(term, backward)) {
+        // wrap-around: try from the other end once
+        if (backward)
+            logView_->moveCursorToEnd();
+        else
+            logView_->moveCursorToStart();
+        if (!logView_->find(term, backward))
+            return false;
+    }
+    // Keep the count in step when the match is already listed
+    const LogView::Position from = logView_->selectionStart();
+    auto it = std::lower_bound(searchMatches_.begin(), searchMatches_.end(), from);
+    currentSearchIndex_ = (it != searchMatches_.end() && *it == from) ? int(it - searchMatches_.begin()) : -1;
+    return true;
 }
 
 void MainWindow::searchDown()
@@ -638,36 +1213,37 @@ void MainWindow::searchDown()
     QString term = searchLine_->text();
     if (term.isEmpty())
         return;
+    flushLog();
+    if (term != searchMatchesTerm_)
+        updateSearchMatches(term);
 
     // If this is the first search after pressing Enter, start from top
     if (term != lastSearchTerm_) {
         lastSearchTerm_ = term;
-        logView_->moveCursor(QTextCursor::Start);
+        logView_->moveCursorToStart();
         currentSearchIndex_ = -1;
     }
 
-    // Try to find next from current cursor; if not, wrap to start once
-    if (!logView_->find(term, QTextDocument::FindCaseSensitively)) {
-        logView_->moveCursor(QTextCursor::Start);
-        if (!logView_->find(term, QTextDocument::FindCaseSensitively)) {
+    // First match at or after the cursor; wrap to start if there is none
+    const LogView::Position from = logView_->selectionEnd();
+    int index = int(std::lower_bound(searchMatches_.begin(), searchMatches_.end(), from) - searchMatches_.begin());
+    if (index == searchMatches_.size() && search_->isRunning()) {
+        // The list has not got past the cursor yet
+        if (!findFromCursor(term, false))
             showMessageAutoClose("Search", "Text not found!", 1500);
-            currentSearchIndex_ = -1;
-            updateSearchCountLabel();
-            return;
-        }
+        updateSearchCountLabel();
+        logView_->setFocus();
+        return;
     }
-
-    // Update current index based on cursor position
-    if (!searchMatches_.isEmpty()) {
-        QTextCursor cursor = logView_->textCursor();
-        int cursorPos = cursor.selectionStart();
-        for (int i = 0; i < searchMatches_.size(); ++i) {
-            if (searchMatches_[i] == cursorPos) {
-                currentSearchIndex_ = i;
-                break;
-            }
-        }
+    if (searchMatches_.isEmpty()) {
+        showMessageAutoClose("Search", "Text not found!", 1500);
+        currentSearchIndex_ = -1;
+        updateSearchCountLabel();
+        return;
     }
+    if (index == searchMatches_.size())
+        index = 0;
+    goToSearchMatch(index);
 
     updateSearchCountLabel();
     logView_->setFocus();
@@ -678,15 +1254,21 @@ void MainWindow::onSearchReturnPressed()
     QString term = searchLine_->text();
     if (term.isEmpty())
         return;
+    flushLog();
 
     // Just highlight all matches - don't jump to first occurrence
     // Highlight is done by updateCompleter which is already connected to textChanged
     highlightSearchResults(term);
+    if (term != searchMatchesTerm_)
+        updateSearchMatches(term);
 
-    // Show message if no matches found
-    QTextDocument *doc = logView_->document();
-    QTextCursor cursor(doc);
-    if (!doc->find(term, cursor).isNull()) {
+    // Show message if no matches found, once the background search knows
+    if (searchMatches_.isEmpty() && search_->isRunning()) {
+        lastSearchTerm_ = term;
+        currentSearchIndex_ = -1;
+        searchNotFoundPending_ = true;
+        updateSearchCountLabel();
+    } else if (!searchMatches_.isEmpty()) {
         // Found at least one match - ready for Up/Down navigation
         lastSearchTerm_ = term;
         currentSearchIndex_ = 0;
@@ -703,30 +1285,30 @@ void MainWindow::searchUp()
     QString term = searchLine_->text();
     if (term.isEmpty())
         return;
-
-    // Try to find previous from current cursor; if not, wrap to end once
-    if (!logView_->find(term, QTextDocument::FindBackward | QTextDocument::FindCaseSensitively)) {
-        logView_->moveCursor(QTextCursor::End);
-        if (!logView_->find(term,
-                            QTextDocument::FindBackward | QTextDocument::FindCaseSensitively)) {
+    flushLog();
+    if (term != searchMatchesTerm_)
+        updateSearchMatches(term);
+
+    // Last match before the cursor; wrap to end if there is none
+    const LogView::Position from = logView_->selectionStart();
+    int index = int(std::lower_bound(searchMatches_.begin(), searchMatches_.end(), from) - searchMatches_.begin()) - 1;
+    if (index == searchMatches_.size() - 1 && search_->isRunning()) {
+        // The list has not got past the cursor yet
+        if (!findFromCursor(term, true))
             showMessageAutoClose("Search", "Text not found!", 1500);
-            currentSearchIndex_ = -1;
-            updateSearchCountLabel();
-            return;
-        }
+        updateSearchCountLabel();
+        logView_->setFocus();
+        return;
     }
-
-    // Update current index based on cursor position
-    if (!searchMatches_.isEmpty()) {
-        QTextCursor cursor = logView_->textCursor();
-        int cursorPos = cursor.selectionStart();
-        for (int i = 0; i < searchMatches_.size(); ++i) {
-            if (searchMatches_[i] == cursorPos) {
-                currentSearchIndex_ = i;
-                break;
-            }
-        }
+    if (searchMatches_.isEmpty()) {
+        showMessageAutoClose("Search", "Text not found!", 1500);
+        currentSearchIndex_ = -1;
+        updateSearchCountLabel();
+        return;
     }
+    if (index < 0)
+        index = searchMatches_.size() - 1;
+    goToSearchMatch(index);
 
     updateSearchCountLabel();
     logView_->setFocus();
@@ -735,6 +1317,332 @@ void MainWindow::searchUp()
 void MainWindow::timerHandler()
 {
     // Periodic tasks can be handled here
+    if (rxStatsLabel_) {
+        // Aggregate over all open ports; per-port rates go in the session list
+        double peakFill = 0.0;
+        double fill = 0.0;
+        quint64 overflows = 0;
+        quint64 dropped = 0;
+        quint64 deliveries = 0;
+        quint64 rxBytes = 0;
+        quint64 txBytes = 0;
+        qint64 txQueued = 0;
+        for (PortSession *session : sessions_) {
+            const SerialWorker *w = session->worker;
+            const SpscRingBuffer &ring = w->rxRing();
+            fill = qMax(fill, ring.fillRatio());
+            peakFill = qMax(peakFill, double(ring.peakSize()) / ring.capacity());
+            overflows += ring.overflowCount();
+            dropped += ring.droppedBytes();
+            deliveries += w->deliveryCount();
+            const quint64 bytes = w->rxByteCount();
+            rxBytes += bytes;
+            txBytes += w->txBytesWritten();
+            txQueued += w->txQueueDepth();
+            session->item->setText(QString("%1  %2 MB/s").arg(session->name)
+                                       .arg((bytes - session->lastRxBytes) / 1e6, 0, 'f', 2));
+            session->lastRxBytes = bytes;
+        }
+        RxBufferPool::Stats pool = RxBufferPool::instance().stats();
+        // timer_ ticks once per second, so the deltas are per-second rates.
+        // Counters restart when ports come and go; clamp the delta at zero.
+        const quint64 rxDelta = rxBytes > lastRxByteCount_ ? rxBytes - lastRxByteCount_ : 0;
+        const quint64 deliveryDelta = deliveries > lastDeliveryCount_ ? deliveries - lastDeliveryCount_ : 0;
+        const quint64 txDelta = txBytes > lastTxByteCount_ ? txBytes - lastTxByteCount_ : 0;
+        rxStatsLabel_->setText(QString("TX: %1 MB/s (queued %2 bytes)  "
+                                       "RX: %3 MB/s  ring: %4% (peak %5%)  overflow: %6 (%7 bytes lost)  updates/s: %8  "
+                                       "pool: %9/%10 blocks (peak %11, misses %12)  log: %13 MiB in memory, %14 MiB on disk, "
+                                       "%15 appends/s in %16 updates/s")
+                                   .arg(txDelta / 1e6, 0, 'f', 2)
+                                   .arg(txQueued)
+                                   .arg(rxDelta / 1e6, 0, 'f', 2)
+                                   .arg(fill * 100.0, 0, 'f', 1)
+                                   .arg(peakFill * 100.0, 0, 'f', 1)
+                                   .arg(overflows)
+                                   .arg(dropped)
+                                   .arg(deliveryDelta)
+                                   .arg(pool.inUse)
+                                   .arg(pool.totalBlocks)
+                                   .arg(pool.peakInUse)
+                                   .arg(pool.misses)
+                                   .arg(logView_->store().memoryUsage() / 1048576.0, 0, 'f', 1)
+                                   .arg(logView_->store().spilledBytes() / 1048576.0, 0, 'f', 1)
+                                   .arg(logAppends_ - lastLogAppends_)
+                                   .arg(logCommits_ - lastLogCommits_));
+        lastLogAppends_ = logAppends_;
+        lastLogCommits_ = logCommits_;
+        if (!logView_->store().spillError().isEmpty() && !scrollbackErrorShown_) {
+            scrollbackErrorShown_ = true;
+            log(QString("Scrollback spill file failed, keeping the whole log in memory: %1\n")
+                    .arg(logView_->store().spillError()));
+        }
+        const QString writerError = logWriter_.errorString();
+        if (!writerError.isEmpty() && writerError != logWriterErrorShown_) {
+            logWriterErrorShown_ = writerError;
+            log(QString("Writing the log to disk failed: %1\n").arg(writerError));
+        }
+        const QString captureError = capture_.errorString();
+        if (!captureError.isEmpty() && captureError != captureErrorShown_) {
+            captureErrorShown_ = captureError;
+            log(QString("Recording the capture failed: %1\n").arg(captureError));
+        }
+        lastDeliveryCount_ = deliveries;
+        lastRxByteCount_ = rxBytes;
+        lastTxByteCount_ = txBytes;
+    }
+
+    updateTrafficGenerator();
+
+    if (replay_ && replay_->isRunning()) {
+        const quint64 total = qMax<quint64>(replay_->bytesTotal(), 1);
+        statusBar()->showMessage(tr("Replaying %1: %2% at %3 MB/s")
+                                     .arg(QFileInfo(replay_->fileName()).fileName())
+                                     .arg(replay_->bytesReplayed() * 100 / total)
+                                     .arg(replay_->pipelineRate() / 1e6, 0, 'f', 3));
+    }
+}
+
+void MainWindow::openTrafficGenerator()
+{
+    if (generator_ && generator_->isRunning()) {
+        QMessageBox::information(this, "Traffic Generator", "Already running on " + generator_->slavePath());
+        return;
+    }
+
+    QDialog *dialog = new QDialog(this);
+    dialog->setWindowTitle(tr("Traffic Generator"));
+    QVBoxLayout *layout = new QVBoxLayout(dialog);
+
+    QHBoxLayout *patternLayout = new QHBoxLayout();
+    QComboBox *patternCombo = new QComboBox();
+    patternCombo->addItem(tr("Text lines"), int(TrafficGenerator::Pattern::Text));
+    patternCombo->addItem(tr("key:value telemetry"), int(TrafficGenerator::Pattern::Telemetry));
+    patternCombo->addItem(tr("Random binary"), int(TrafficGenerator::Pattern::Binary));
+    patternCombo->addItem(tr("Telemetry bursts (100 ms)"), int(TrafficGenerator::Pattern::Burst));
+    patternLayout->addWidget(new QLabel(tr("Pattern:")));
+    patternLayout->addWidget(patternCombo);
+    patternLayout->addStretch();
+    layout->addLayout(patternLayout);
+
+    QHBoxLayout *rateLayout = new QHBoxLayout();
+    QSpinBox *rateSpin = new QSpinBox();
+    rateSpin->setRange(1, 500000);
+    rateSpin->setValue(1000);
+    rateSpin->setSuffix(tr(" KB/s"));
+    QCheckBox *rampCheck = new QCheckBox(tr("Ramp up until the app falls behind"));
+    rampCheck->setToolTip(tr("Raise the rate by 25% every second; stop at the first drop or lag"));
+    rateLayout->addWidget(new QLabel(tr("Rate:")));
+    rateLayout->addWidget(rateSpin);
+    rateLayout->addWidget(rampCheck);
+    rateLayout->addStretch();
+    layout->addLayout(rateLayout);
+
+    QHBoxLayout *buttonLayout = new QHBoxLayout();
+    QPushButton *startBtn = new QPushButton(tr("Start"));
+    QPushButton *cancelBtn = new QPushButton(tr("Cancel"));
+    buttonLayout->addStretch();
+    buttonLayout->addWidget(startBtn);
+    buttonLayout->addWidget(cancelBtn);
+    layout->addLayout(buttonLayout);
+
+    connect(startBtn, &QPushButton::clicked, dialog, &QDialog::accept);
+    connect(cancelBtn, &QPushButton::clicked, dialog, &QDialog::reject);
+    const bool accepted = dialog->exec() == QDialog::Accepted;
+    const auto pattern = TrafficGenerator::Pattern(patternCombo->currentData().toInt());
+    const qint64 rate = qint64(rateSpin->value()) * 1000;
+    generatorRamp_ = rampCheck->isChecked();
+    dialog->deleteLater();
+    if (!accepted)
+        return;
+
+    if (!generator_)
+        generator_ = new TrafficGenerator;
+    if (!generator_->start(pattern, rate)) {
+        QMessageBox::critical(this, "Traffic Generator", generator_->errorString());
+        return;
+    }
+    // The baud rate means nothing on a pty; use the current selection
+    int baud = qMax(1, baudCombo_->currentText().toInt());
+    if (!openPortSession(generator_->slavePath(), baud)) {
+        generator_->stop();
+        return;
+    }
+    generatorStartNs_ = SerialWorker::monotonicNs();
+    generatorLastReceived_ = 0;
+    generatorLastDropped_ = 0;
+    generatorSustained_ = 0.0;
+    log(QString("Traffic generator on %1 at %2 MB/s%3\n")
+            .arg(generator_->slavePath())
+            .arg(rate / 1e6, 0, 'f', 3)
+            .arg(generatorRamp_ ? " (ramping)" : ""));
+}
+
+void MainWindow::updateTrafficGenerator()
+{
+    if (!generator_ || !generator_->isRunning())
+        return;
+    PortSession *session = findSession(generator_->slavePath());
+    if (!session) {
+        stopTrafficGenerator("port closed");
+        return;
+    }
+
+    // Called once per second, so deltas are per-second rates. The sustained
+    // rate is what the app took in and kept, not what the generator wrote:
+    // bytes the worker read minus those the RX ring had to drop.
+    const quint64 dropped = session->worker->rxRing().droppedBytes();
+    const quint64 received = session->worker->rxByteCount() - dropped;
+    const qint64 rate = generator_->rate();
+    const double receivedRate = double(received - generatorLastReceived_);
+    generatorLastReceived_ = received;
+
+    // Behind: the RX ring dropped data, or the pty is backed up by more than
+    // a quarter second of traffic because the app is not reading fast enough
+    if (dropped > generatorLastDropped_) {
+        stopTrafficGenerator(QString("%1 bytes dropped at %2 MB/s").arg(dropped - generatorLastDropped_)
+                                 .arg(rate / 1e6, 0, 'f', 3));
+        return;
+    }
+    if (generator_->lagBytes() > rate / 4) {
+        stopTrafficGenerator(QString("%1 ms behind at %2 MB/s").arg(generator_->lagBytes() * 1000 / rate)
+                                 .arg(rate / 1e6, 0, 'f', 3));
+        return;
+    }
+    generatorSustained_ = qMax(generatorSustained_, receivedRate);
+    if (generatorRamp_)
+        generator_->setRate(rate + rate / 4);
+}
+
+void MainWindow::stopTrafficGenerator(const QString &reason)
+{
+    if (!generator_ || !generator_->isRunning())
+        return;
+
+    // Close the app side first so the worker does not see the pty vanish
+    const QString path = generator_->slavePath();
+    const quint64 written = generator_->bytesWritten();
+    quint64 received = 0;
+    quint64 dropped = 0;
+    if (PortSession *session = findSession(path)) {
+        dropped = session->worker->rxRing().droppedBytes();
+        received = session->worker->rxByteCount() - dropped;
+        closeSession(session);
+    }
+    generator_->stop();
+
+    // Whatever was written but neither kept nor dropped was still in the
+    // pty, unread, when the generator stopped
+    const quint64 backlog = written > received + dropped ? written - received - dropped : 0;
+    const double seconds = double(SerialWorker::monotonicNs() - generatorStartNs_) / 1e9;
+    log(QString("Traffic generator stopped%1. Sent %2 bytes, received %3 bytes in %4 s "
+                "(%5 lost, %6 unread), %7 pty stalls. Sustained rate: %8 MB/s\n")
+            .arg(reason.isEmpty() ? QString() : ": " + reason)
+            .arg(written)
+            .arg(received)
+            .arg(seconds, 0, 'f', 1)
+            .arg(dropped)
+            .arg(backlog)
+            .arg(generator_->stallCount())
+            .arg(generatorSustained_ / 1e6, 0, 'f', 3));
+}
+
+void MainWindow::openReplay()
+{
+    const QString path = QFileDialog::getOpenFileName(this, tr("Replay Capture"),
+                                                      QDir(QDir::currentPath()).filePath("log"),
+                                                      tr("Captures (*.sgcap);;All Files (*)"));
+    if (path.isEmpty())
+        return;
+    bool ok = false;
+    const double speed = QInputDialog::getDouble(this, tr("Replay Capture"),
+                                                 tr("Speed (x real time, 0 = as fast as possible):"),
+                                                 1.0, 0.0, 10000.0, 1, &ok);
+    if (!ok)
+        return;
+    // Found through the block index; nothing before it is inflated
+    const QString from = QInputDialog::getText(this, tr("Replay Capture"),
+                                               tr("Start at (seconds, or a byte offset such as 1048576B):"),
+                                               QLineEdit::Normal, "0", &ok).trimmed();
+    if (!ok)
+        return;
+    CaptureReplay::SeekBy seekBy = CaptureReplay::SeekBy::Time;
+    qint64 offset = 0;
+    if (from.endsWith('B', Qt::CaseInsensitive)) {
+        seekBy = CaptureReplay::SeekBy::Byte;
+        offset = from.chopped(1).trimmed().toLongLong(&ok);
+    } else {
+        offset = qint64(from.toDouble(&ok) * 1e9);
+    }
+    if (!ok || offset < 0) {
+        QMessageBox::warning(this, tr("Replay Capture"), tr("Not a start point: %1").arg(from));
+        return;
+    }
+
+    if (!replay_) {
+        replay_ = new CaptureReplay(this);
+        // Same entry point as SerialWorker::dataReceived
+        connect(replay_, &CaptureReplay::dataReceived, this, [this](const QString &port, const RxChunk &chunk) {
+            onSessionData(replaySession(port), chunk);
+        });
+        connect(replay_, &CaptureReplay::dataSent, this, [this](const QString &port, const QByteArray &data) {
+            replaySession(port);
+            const QString tag = sessions_.size() + replaySessions_.size() > 1 ? '[' + port + "] " : QString();
+            if (hexCheck_->isChecked())
+                log(tag + "TX (HEX): " + data.toHex(' ').toUpper() + '\n');
+            else
+                log(tag + "TX: " + QString::fromUtf8(data) + (data.endsWith('\n') ? "" : "\n"));
+        });
+        connect(replay_, &CaptureReplay::finished, this, &MainWindow::onReplayFinished);
+    }
+    replay_->stop();
+    // The replay starts from a clean log and plot, like a fresh session
+    clearLog();
+    initFlag_ = false;
+    if (!replay_->start(path, speed, seekBy, offset)) {
+        QMessageBox::critical(this, tr("Replay Capture"), replay_->errorString());
+        return;
+    }
+    log(QString("Replaying %1 at %2 from %3\n")
+            .arg(path)
+            .arg(speed > 0 ? QString("%1x").arg(speed) : QString("full speed"))
+            .arg(seekBy == CaptureReplay::SeekBy::Byte ? QString("byte %1").arg(offset)
+                                                       : QString("%1 s").arg(offset / 1e9, 0, 'f', 3)));
+}
+
+PortSession *MainWindow::replaySession(const QString &port)
+{
+    for (PortSession *session : replaySessions_) {
+        if (session->name == port)
+            return session;
+    }
+    if (sessions_.size() + replaySessions_.size() == 1)
+        startMergedLog(port);
+    PortSession *session = new PortSession;
+    session->name = port;
+    session->framer.reset(Framer::create(rxFraming_));
+    replaySessions_.append(session);
+    return session;
+}
+
+void MainWindow::onReplayFinished(bool stopped)
+{
+    // Merged lines still point at the replay sessions
+    flushTimeline(true);
+    statusBar()->clearMessage();
+    QString result = QString("Replay %1: %2 of %3 bytes in %4 s (%5 s reading blocks)")
+                         .arg(stopped ? "stopped" : "done")
+                         .arg(replay_->bytesReplayed())
+                         .arg(replay_->bytesTotal())
+                         .arg(replay_->elapsedNs() / 1e9, 0, 'f', 2)
+                         .arg(replay_->decodeNs() / 1e9, 0, 'f', 2);
+    if (replay_->damagedBlocks() > 0)
+        result += QString(", %1 damaged block(s) skipped").arg(replay_->damagedBlocks());
+    // Flat out, the rate is what the framer, log and plotter keep up with
+    if (replay_->speed() <= 0)
+        result += QString(". Sustained rate: %1 MB/s").arg(replay_->pipelineRate() / 1e6, 0, 'f', 3);
+    log(result + "\n");
+    qDeleteAll(replaySessions_);
+    replaySessions_.clear();
 }
 
 void MainWindow::showMessageAutoClose(const QString &title, const QString &msg, int timeoutMs)
@@ -1026,14 +1934,142 @@ void MainWindow::openSettings()
     searchHlLayout->addStretch();
     layout->addLayout(searchHlLayout);
 
-    // Auto Save on Exit Setting
-    QHBoxLayout *autoSaveLayout = new QHBoxLayout();
-    QCheckBox *autoSaveCheck = new QCheckBox(tr("Auto-save log when exiting"));
-    autoSaveCheck->setChecked(autoSaveOnExit_);
-    autoSaveCheck->setToolTip(tr("If checked, log will be automatically saved to log/ folder when exiting the app"));
-    autoSaveLayout->addWidget(autoSaveCheck);
-    autoSaveLayout->addStretch();
-    layout->addLayout(autoSaveLayout);
+    // RX delivery: frame-paced coalescing
+    QHBoxLayout *rxLayout = new QHBoxLayout();
+    QCheckBox *rxFramePacedCheck = new QCheckBox(tr("Frame-paced RX delivery"));
+    rxFramePacedCheck->setChecked(rxFramePaced_);
+    rxFramePacedCheck->setToolTip(tr("Gather received data and update the log once per frame instead of once per driver read"));
+    QLabel *rxIntervalLabel = new QLabel(tr("Interval (ms):"));
+    QSpinBox *rxIntervalSpin = new QSpinBox();
+    rxIntervalSpin->setRange(1, 1000);
+    rxIntervalSpin->setValue(rxFrameIntervalMs_);
+    QLabel *rxBudgetLabel = new QLabel(tr("Budget (KiB, 0 = unlimited):"));
+    QSpinBox *rxBudgetSpin = new QSpinBox();
+    rxBudgetSpin->setRange(0, 64 * 1024);
+    rxBudgetSpin->setValue(rxFlushBudgetKiB_);
+    rxLayout->addWidget(rxFramePacedCheck);
+    rxLayout->addWidget(rxIntervalLabel);
+    rxLayout->addWidget(rxIntervalSpin);
+    rxLayout->addWidget(rxBudgetLabel);
+    rxLayout->addWidget(rxBudgetSpin);
+    rxLayout->addStretch();
+    layout->addLayout(rxLayout);
+
+    // RX framing used for plotting and the multi-port timeline
+    QHBoxLayout *framingLayout = new QHBoxLayout();
+    QLabel *framingLabel = new QLabel(tr("RX framing:"));
+    QComboBox *framingCombo = new QComboBox();
+    framingCombo->addItem(tr("LF or ETX (0xDD)"), int(Framer::Kind::LineOrEtx));
+    framingCombo->addItem(tr("LF (\\n)"), int(Framer::Kind::Lf));
+    framingCombo->addItem(tr("CR+LF (\\r\\n)"), int(Framer::Kind::CrLf));
+    framingCombo->addItem(tr("ETX (0xDD)"), int(Framer::Kind::Etx));
+    framingCombo->addItem(tr("SLIP"), int(Framer::Kind::Slip));
+    framingCombo->addItem(tr("COBS"), int(Framer::Kind::Cobs));
+    framingCombo->addItem(tr("Length-prefixed (16-bit BE)"), int(Framer::Kind::LengthPrefixed));
+    framingCombo->setCurrentIndex(framingCombo->findData(int(rxFraming_)));
+    framingCombo->setToolTip(tr("Applies to ports opened afterwards"));
+    framingLayout->addWidget(framingLabel);
+    framingLayout->addWidget(framingCombo);
+    framingLayout->addStretch();
+    layout->addLayout(framingLayout);
+
+    // In-memory scrollback; older lines go to a spill file under log/
+    QHBoxLayout *scrollbackLayout = new QHBoxLayout();
+    QLabel *scrollbackLabel = new QLabel(tr("Scrollback in memory (MiB, 0 = unlimited):"));
+    QSpinBox *scrollbackSpin = new QSpinBox();
+    scrollbackSpin->setRange(0, 64 * 1024);
+    scrollbackSpin->setValue(scrollbackMiB_);
+    scrollbackSpin->setToolTip(tr("Older lines are moved to a file in log/ and can still be scrolled to, searched and saved"));
+    scrollbackLayout->addWidget(scrollbackLabel);
+    scrollbackLayout->addWidget(scrollbackSpin);
+    scrollbackLayout->addStretch();
+    layout->addLayout(scrollbackLayout);
+
+    // Serial backend
+    QHBoxLayout *backendLayout = new QHBoxLayout();
+    QLabel *backendLabel = new QLabel(tr("Serial backend:"));
+    QComboBox *backendCombo = new QComboBox();
+    backendCombo->addItem(tr("Qt (QSerialPort)"), false);
+    backendCombo->addItem(tr("Native Linux (termios/epoll)"), true);
+    backendCombo->setCurrentIndex(nativeBackend_ ? 1 : 0);
+    backendCombo->setToolTip(tr("Takes effect the next time a port is opened"));
+    QLabel *vminLabel = new QLabel(tr("VMIN:"));
+    QSpinBox *vminSpin = new QSpinBox();
+    vminSpin->setRange(0, 255);
+    vminSpin->setValue(nativeVmin_);
+    QLabel *vtimeLabel = new QLabel(tr("VTIME (1/10 s):"));
+    QSpinBox *vtimeSpin = new QSpinBox();
+    vtimeSpin->setRange(0, 255);
+    vtimeSpin->setValue(nativeVtime_);
+    QCheckBox *lowLatencyCheck = new QCheckBox(tr("Low latency"));
+    lowLatencyCheck->setChecked(nativeLowLatency_);
+    lowLatencyCheck->setToolTip(tr("Set ASYNC_LOW_LATENCY on drivers that support it"));
+    QCheckBox *throughputCheck = new QCheckBox(tr("Throughput mode"));
+    throughputCheck->setChecked(throughputMode_);
+    throughputCheck->setToolTip(tr("Large reads and a 32 MiB RX ring for multi-megabaud streams"));
+    backendLayout->addWidget(backendLabel);
+    backendLayout->addWidget(backendCombo);
+    backendLayout->addWidget(vminLabel);
+    backendLayout->addWidget(vminSpin);
+    backendLayout->addWidget(vtimeLabel);
+    backendLayout->addWidget(vtimeSpin);
+    backendLayout->addWidget(lowLatencyCheck);
+    backendLayout->addWidget(throughputCheck);
+    backendLayout->addStretch();
+    layout->addLayout(backendLayout);
+
+    // Log to disk as it arrives
+    QHBoxLayout *logDiskLayout = new QHBoxLayout();
+    QCheckBox *logDiskCheck = new QCheckBox(tr("Write log to log/ as it arrives"));
+    logDiskCheck->setChecked(logToDisk_);
+    logDiskCheck->setToolTip(tr("Streamed from a background thread; a crash loses at most the last fraction of a second"));
+    QLabel *rotateSizeLabel = new QLabel(tr("New file every (MiB):"));
+    QSpinBox *rotateSizeSpin = new QSpinBox();
+    rotateSizeSpin->setRange(0, 64 * 1024);
+    rotateSizeSpin->setValue(logRotateMiB_);
+    rotateSizeSpin->setSpecialValueText(tr("never"));
+    QLabel *rotateTimeLabel = new QLabel(tr("or (min):"));
+    QSpinBox *rotateTimeSpin = new QSpinBox();
+    rotateTimeSpin->setRange(0, 7 * 24 * 60);
+    rotateTimeSpin->setValue(logRotateMinutes_);
+    rotateTimeSpin->setSpecialValueText(tr("never"));
+    QLabel *syncLabel = new QLabel(tr("fsync:"));
+    QComboBox *syncCombo = new QComboBox();
+    syncCombo->addItem(tr("Never"), int(LogFileWriter::SyncPolicy::Never));
+    syncCombo->addItem(tr("Every write"), int(LogFileWriter::SyncPolicy::EveryBatch));
+    syncCombo->addItem(tr("Every second"), int(LogFileWriter::SyncPolicy::Interval));
+    syncCombo->setCurrentIndex(syncCombo->findData(int(logSync_)));
+    QLabel *keepLabel = new QLabel(tr("Keep at most (files):"));
+    QSpinBox *keepFilesSpin = new QSpinBox();
+    keepFilesSpin->setRange(0, 100000);
+    keepFilesSpin->setValue(logKeepFiles_);
+    keepFilesSpin->setSpecialValueText(tr("all"));
+    QLabel *keepSizeLabel = new QLabel(tr("and (MiB):"));
+    QSpinBox *keepSizeSpin = new QSpinBox();
+    keepSizeSpin->setRange(0, 1024 * 1024);
+    keepSizeSpin->setValue(logKeepMiB_);
+    keepSizeSpin->setSpecialValueText(tr("no limit"));
+    keepSizeSpin->setToolTip(tr("The oldest stream_*.txt files in log/ are deleted when a new file is started"));
+    logDiskLayout->addWidget(logDiskCheck);
+    logDiskLayout->addWidget(rotateSizeLabel);
+    logDiskLayout->addWidget(rotateSizeSpin);
+    logDiskLayout->addWidget(rotateTimeLabel);
+    logDiskLayout->addWidget(rotateTimeSpin);
+    logDiskLayout->addWidget(syncLabel);
+    logDiskLayout->addWidget(syncCombo);
+    logDiskLayout->addStretch();
+    layout->addLayout(logDiskLayout);
+    QHBoxLayout *logKeepLayout = new QHBoxLayout();
+    logKeepLayout->addWidget(keepLabel);
+    logKeepLayout->addWidget(keepFilesSpin);
+    logKeepLayout->addWidget(keepSizeLabel);
+    logKeepLayout->addWidget(keepSizeSpin);
+    logKeepLayout->addStretch();
+    layout->addLayout(logKeepLayout);
+    QCheckBox *captureCheck = new QCheckBox(tr("Also record raw RX/TX to log/ (.sgcap)"));
+    captureCheck->setChecked(captureToDisk_);
+    captureCheck->setToolTip(tr("Timestamped, compressed capture that File > Open shows again"));
+    layout->addWidget(captureCheck);
 
     layout->addStretch();
 
@@ -1046,12 +2082,36 @@ void MainWindow::openSettings()
     buttonLayout->addWidget(cancelBtn);
     layout->addLayout(buttonLayout);
 
-    connect(okBtn, &QPushButton::clicked, dialog, [this, fontCombo, eolCombo, group1Edit, group2Edit, autoSaveCheck, dialog]() {
+    connect(okBtn, &QPushButton::clicked, dialog, [this, fontCombo, eolCombo, group1Edit, group2Edit, logDiskCheck,
+                                                   rotateSizeSpin, rotateTimeSpin, syncCombo, keepFilesSpin,
+                                                   keepSizeSpin, captureCheck,
+                                                   rxFramePacedCheck, rxIntervalSpin, rxBudgetSpin, framingCombo,
+                                                   scrollbackSpin, backendCombo, vminSpin, vtimeSpin, lowLatencyCheck, throughputCheck, dialog]() {
         logFontSize_ = fontCombo->currentData().toInt();
         eolMode_ = eolCombo->currentData().toString();
         quickGroup1Label_ = group1Edit->text();
         quickGroup2Label_ = group2Edit->text();
-        autoSaveOnExit_ = autoSaveCheck->isChecked();
+        logToDisk_ = logDiskCheck->isChecked();
+        logRotateMiB_ = rotateSizeSpin->value();
+        logRotateMinutes_ = rotateTimeSpin->value();
+        logSync_ = LogFileWriter::SyncPolicy(syncCombo->currentData().toInt());
+        logKeepFiles_ = keepFilesSpin->value();
+        logKeepMiB_ = keepSizeSpin->value();
+        applyLogWriterSettings();
+        captureToDisk_ = captureCheck->isChecked();
+        applyCaptureSettings();
+        rxFramePaced_ = rxFramePacedCheck->isChecked();
+        rxFrameIntervalMs_ = rxIntervalSpin->value();
+        rxFlushBudgetKiB_ = rxBudgetSpin->value();
+        applyRxDeliverySettings();
+        rxFraming_ = Framer::Kind(framingCombo->currentData().toInt());
+        scrollbackMiB_ = scrollbackSpin->value();
+        applyScrollbackSettings();
+        nativeBackend_ = backendCombo->currentData().toBool();
+        nativeVmin_ = vminSpin->value();
+        nativeVtime_ = vtimeSpin->value();
+        nativeLowLatency_ = lowLatencyCheck->isChecked();
+        throughputMode_ = throughputCheck->isChecked();
 
         // Apply font size to logView_
         // Apply font size and colors to logView_
@@ -1141,11 +2201,31 @@ void MainWindow::saveSettings()
         eolModeStr = "LF";
 
     out << "EOLMode=" << eolModeStr << "\n";
-    out << "AutoSaveOnExit=" << (autoSaveOnExit_ ? "true" : "false") << "\n";
+    out << "LogToDisk=" << (logToDisk_ ? "true" : "false") << "\n";
+    out << "LogRotateMiB=" << logRotateMiB_ << "\n";
+    out << "LogRotateMinutes=" << logRotateMinutes_ << "\n";
+    out << "LogKeepFiles=" << logKeepFiles_ << "\n";
+    out << "LogKeepMiB=" << logKeepMiB_ << "\n";
+    out << "LogSync="
+        << (logSync_ == LogFileWriter::SyncPolicy::Never        ? "NEVER"
+            : logSync_ == LogFileWriter::SyncPolicy::EveryBatch ? "BATCH"
+                                                                : "INTERVAL")
+        << "\n";
+    out << "CaptureToDisk=" << (captureToDisk_ ? "true" : "false") << "\n";
     out << "AutoScroll=" << (autoScrollEnabled_ ? "true" : "false") << "\n";
     out << "LogBgColor=" << logBgColor_.name() << "\n";
     out << "LogTextColor=" << logTextColor_.name() << "\n";
     out << "SearchHighlightColor=" << searchHighlightColor_.name() << "\n";
+    out << "RxDeliveryMode=" << (rxFramePaced_ ? "FRAME" : "IMMEDIATE") << "\n";
+    out << "RxFrameIntervalMs=" << rxFrameIntervalMs_ << "\n";
+    out << "RxFlushBudgetKiB=" << rxFlushBudgetKiB_ << "\n";
+    out << "SerialBackend=" << (nativeBackend_ ? "NATIVE" : "QT") << "\n";
+    out << "NativeVmin=" << nativeVmin_ << "\n";
+    out << "NativeVtime=" << nativeVtime_ << "\n";
+    out << "NativeLowLatency=" << (nativeLowLatency_ ? "true" : "false") << "\n";
+    out << "ThroughputMode=" << (throughputMode_ ? "true" : "false") << "\n";
+    out << "RxFraming=" << Framer::kindName(rxFraming_) << "\n";
+    out << "ScrollbackMiB=" << scrollbackMiB_ << "\n";
     file.close();
 }
 
@@ -1197,10 +2277,51 @@ void MainWindow::loadSettings()
                 eolMode_ = "\r\n";
             else
                 eolMode_ = "\n";
+        } else if (key == "LogToDisk") {
+            logToDisk_ = (value == "true");
         } else if (key == "AutoSaveOnExit") {
-            autoSaveOnExit_ = (value == "true");
+            // Settings from before the log was streamed: whoever had it
+            // saved on exit gets it written as it arrives
+            logToDisk_ = (value == "true");
+        } else if (key == "LogRotateMiB") {
+            logRotateMiB_ = qMax(0, value.toInt());
+        } else if (key == "LogRotateMinutes") {
+            logRotateMinutes_ = qMax(0, value.toInt());
+        } else if (key == "LogKeepFiles") {
+            logKeepFiles_ = qMax(0, value.toInt());
+        } else if (key == "LogKeepMiB") {
+            logKeepMiB_ = qMax(0, value.toInt());
+        } else if (key == "LogSync") {
+            if (value == "NEVER")
+                logSync_ = LogFileWriter::SyncPolicy::Never;
+            else if (value == "BATCH")
+                logSync_ = LogFileWriter::SyncPolicy::EveryBatch;
+            else
+                logSync_ = LogFileWriter::SyncPolicy::Interval;
+        } else if (key == "CaptureToDisk") {
+            captureToDisk_ = (value == "true");
         } else if (key == "AutoScroll") {
             autoScrollEnabled_ = (value == "true");
+        } else if (key == "RxDeliveryMode") {
+            rxFramePaced_ = (value != "IMMEDIATE");
+        } else if (key == "RxFrameIntervalMs") {
+            rxFrameIntervalMs_ = qBound(1, value.toInt(), 1000);
+        } else if (key == "RxFlushBudgetKiB") {
+            rxFlushBudgetKiB_ = qMax(0, value.toInt());
+        } else if (key == "SerialBackend") {
+            nativeBackend_ = (value == "NATIVE");
+        } else if (key == "NativeVmin") {
+            nativeVmin_ = qBound(0, value.toInt(), 255);
+        } else if (key == "NativeVtime") {
+            nativeVtime_ = qBound(0, value.toInt(), 255);
+        } else if (key == "NativeLowLatency") {
+            nativeLowLatency_ = (value == "true");
+        } else if (key == "ThroughputMode") {
+            throughputMode_ = (value == "true");
+        } else if (key == "RxFraming") {
+            rxFraming_ = Framer::kindFromName(value);
+        } else if (key == "ScrollbackMiB") {
+            scrollbackMiB_ = qMax(0, value.toInt());
         }
     }
     file.close();
@@ -1211,6 +2332,64 @@ void MainWindow::loadSettings()
                                 .arg(logTextColor_.name()));
 }
 
+void MainWindow::applyRxDeliverySettings()
+{
+    for (PortSession *session : sessions_) {
+        SerialWorker *w = session->worker;
+        w->setDeliveryMode(rxFramePaced_ ? SerialWorker::DeliveryMode::FramePaced
+                                         : SerialWorker::DeliveryMode::Immediate);
+        w->setFrameInterval(rxFrameIntervalMs_);
+        w->setFlushBudget(qint64(rxFlushBudgetKiB_) * 1024);
+    }
+    if (mergeTimer_)
+        mergeTimer_->setInterval(rxFrameIntervalMs_);
+    if (logFlushTimer_)
+        logFlushTimer_->setInterval(rxFrameIntervalMs_);
+}
+
+void MainWindow::applyScrollbackSettings()
+{
+    logView_->setScrollbackLimit(qint64(scrollbackMiB_) * 1024 * 1024,
+                                 QDir(QDir::currentPath()).filePath("log"));
+}
+
+void MainWindow::applyLogWriterSettings()
+{
+    LogFileWriter::Settings s;
+    s.dir = QDir(QDir::currentPath()).filePath("log");
+    s.maxFileBytes = qint64(logRotateMiB_) * 1024 * 1024;
+    s.maxFileMinutes = logRotateMinutes_;
+    s.sync = logSync_;
+    s.keepFiles = logKeepFiles_;
+    s.keepBytes = qint64(logKeepMiB_) * 1024 * 1024;
+    if (logWriter_.isRunning()) {
+        const LogFileWriter::Settings cur = logWriter_.settings();
+        if (logToDisk_ && cur.dir == s.dir && cur.maxFileBytes == s.maxFileBytes
+            && cur.maxFileMinutes == s.maxFileMinutes && cur.sync == s.sync && cur.keepFiles == s.keepFiles
+            && cur.keepBytes == s.keepBytes)
+            return;
+        logWriter_.stop();
+    }
+    if (logToDisk_)
+        logWriter_.start(s);
+}
+
+void MainWindow::applyCaptureSettings()
+{
+    if (capture_.isOpen() == captureToDisk_)
+        return;
+    if (!captureToDisk_) {
+        capture_.close();
+        return;
+    }
+    QDir dir(QDir::currentPath());
+    dir.mkpath("log");
+    const QString stamp = QDateTime::currentDateTime().toString("yyMMdd_hhmmss");
+    const QString path = dir.filePath(QString("log/capture_%1.sgcap").arg(stamp));
+    // A failure shows up through capture_.errorString() in timerHandler()
+    capture_.open(path);
+}
+
 void MainWindow::saveQuickGroupLabels()
 {
     QDir dir(QDir::currentPath());
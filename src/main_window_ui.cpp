@@ -14,10 +14,14 @@
 #include <QTimer>
 #include <QVBoxLayout>
 #include <QCompleter>
+#include <QStringListModel>
 #include <QCheckBox>
 #include <QInputDialog>
 #include <QDir>
 #include <QTextStream>
+#include <QIntValidator>
+#include <QListWidget>
+#include <QProgressBar>
 
 // This file contains UI construction and widget wiring for MainWindow.
 // Kept separate to make main_window.cpp shorter and focused on logic.
@@ -33,6 +37,8 @@ void MainWindow::setupUi()
     loadBtn_ = new QPushButton(tr("Find Port"));
     openBtn_ = new QPushButton(tr("Open"));
     spaceBtn_ = new QPushButton(tr("Space"));
+    noteBtn_ = new QPushButton(tr("Note"));
+    noteBtn_->setToolTip(tr("Insert a timestamped note line into the log"));
     closeBtn_ = new QPushButton(tr("Close"));
     sendBtn_ = new QPushButton(tr("Send"));
     cmdLoadBtn_ = new QPushButton(tr("Load"));
@@ -47,24 +53,21 @@ void MainWindow::setupUi()
     searchCountLabel_ = new QLabel(this);
     searchCountLabel_->setText("");
     searchCountLabel_->setMaximumWidth(60);
-    logView_ = new QPlainTextEdit(this);
-    logView_->setReadOnly(true);
+    logView_ = new LogView(this);
     logView_->setStyleSheet(QString("font-size: %1px;").arg(logFontSize_));
     // logView_->setStyleSheet("background-color: black; color: white;");
     // QFont font = logView_->font();
     // font.setPointSize(13);
     // logView_->setFont(font);
     hexCheck_ = new QCheckBox(tr("HEX"));
+    rtsCtsCheck_ = new QCheckBox(tr("RTS/CTS"), this);
+    rtsCtsCheck_->setToolTip(tr("Use hardware (RTS/CTS) flow control when opening the port"));
     sendHex_ = new QCheckBox(tr("HEX"), this);
     sendHex_->setToolTip(tr("Send data as hex instead of UTF-8"));
     autoScrollCheck_ = new QCheckBox(tr("Auto Scroll"), this);
     autoScrollCheck_->setChecked(true);
     autoScrollCheck_->setToolTip(tr("Automatically scroll to the end when new data arrives"));
 
-    logReadOnlyCheck_ = new QCheckBox(tr("Read Only"), this);
-    logReadOnlyCheck_->setChecked(true);
-    logReadOnlyCheck_->setToolTip(tr("Set read only mode for log view"));
-
     // Quick-send buttons (user-assignable). They will be shown to the
     // right of the log view in two groups (0-4 and 5-9).
     quickBtn1_ = new QPushButton(tr("CMD0"), this);
@@ -132,7 +135,8 @@ void MainWindow::setupUi()
     }
 
     QStringList historyList = {"Error", "RX:", "Variable_1"};
-    completer_ = new QCompleter(historyList, this);
+    completionModel_ = new QStringListModel(historyList, this);
+    completer_ = new QCompleter(completionModel_, this);
     completer_->setCaseSensitivity(Qt::CaseInsensitive);
     completer_->setCompletionMode(QCompleter::PopupCompletion);
     searchLine_->setCompleter(completer_);
@@ -140,10 +144,15 @@ void MainWindow::setupUi()
     timer_ = new QTimer(this);
     timer_->setInterval(1000); // 1 second interval
 
-    // Populate baud rates
-    const QList<int> baudRates = {9600, 19200, 38400, 57600, 115200, 230400, 460800, 921600};
+    // Populate baud rates. The combo is editable so any custom rate can be typed.
+    const QList<int> baudRates = {9600, 19200, 38400, 57600, 115200, 230400, 460800, 921600,
+                                  1000000, 1500000, 2000000, 3000000, 4000000, 6000000,
+                                  8000000, 12000000};
     for (int b : baudRates)
         baudCombo_->addItem(QString::number(b), b);
+    baudCombo_->setEditable(true);
+    baudCombo_->setInsertPolicy(QComboBox::NoInsert);
+    baudCombo_->setValidator(new QIntValidator(1, 100000000, baudCombo_));
     baudCombo_->setCurrentText("115200");
 
     QHBoxLayout *h1 = new QHBoxLayout();
@@ -166,10 +175,11 @@ void MainWindow::setupUi()
 
     h1->addWidget(baudCombo_);
     h1->addSpacing(10);
+    h1->addWidget(rtsCtsCheck_);
     h1->addWidget(hexCheck_);
     h1->addWidget(autoScrollCheck_);
-    h1->addWidget(logReadOnlyCheck_);
     h1->addWidget(spaceBtn_);
+    h1->addWidget(noteBtn_);
     h1->addWidget(openBtn_);
     h1->addWidget(closeBtn_);
 
@@ -266,6 +276,15 @@ void MainWindow::setupUi()
     quickGroup2Label_ = "Group 2";
     quickGroup2Box_ = createQuickGroup(quickGroup2Label_, group2Btns, group2Edits, 5);
 
+    // Open ports: select = TX target, checkbox = show its lines in the log
+    QLabel *sessionLabel = new QLabel(tr("Open Ports"), this);
+    sessionList_ = new QListWidget(this);
+    sessionList_->setMaximumHeight(110);
+    sessionList_->setMaximumWidth(160);
+    sessionList_->setToolTip(tr("Selected port receives sent commands; uncheck to hide its lines"));
+    quickLayout->addWidget(sessionLabel);
+    quickLayout->addWidget(sessionList_);
+
     quickLayout->addWidget(quickGroup1Box_);
     quickLayout->addWidget(quickGroup2Box_);
     // Batch command area: multi-line edit and Send All button placed under Group 2
@@ -278,10 +297,27 @@ void MainWindow::setupUi()
     cmdListView_->setPlainText(loadCommandsFromFile());
     sendAllBtn_ = new QPushButton(tr("Send All"), this);
     sendAllBtn_->setMaximumWidth(100);
-    // Add label, editor and button to the quick panel
+    batchPauseBtn_ = new QPushButton(tr("Pause"), this);
+    batchPauseBtn_->setMaximumWidth(70);
+    batchPauseBtn_->setEnabled(false);
+    batchCancelBtn_ = new QPushButton(tr("Cancel"), this);
+    batchCancelBtn_->setMaximumWidth(70);
+    batchCancelBtn_->setEnabled(false);
+    batchProgress_ = new QProgressBar(this);
+    batchProgress_->setMaximumWidth(240);
+    batchProgress_->setFormat(tr("%v / %m"));
+    batchProgress_->hide();
+    batch_ = new BatchScheduler(this);
+    QHBoxLayout *batchBtnLayout = new QHBoxLayout();
+    batchBtnLayout->addWidget(sendAllBtn_);
+    batchBtnLayout->addWidget(batchPauseBtn_);
+    batchBtnLayout->addWidget(batchCancelBtn_);
+    batchBtnLayout->addStretch(1);
+    // Add label, editor, buttons and progress to the quick panel
     quickLayout->addWidget(batchLabel);
     quickLayout->addWidget(cmdListView_);
-    quickLayout->addWidget(sendAllBtn_);
+    quickLayout->addLayout(batchBtnLayout);
+    quickLayout->addWidget(batchProgress_);
     quickLayout->addStretch(1);
     mainArea->addWidget(quickContainer, /*stretch=*/0);
 
@@ -295,19 +331,32 @@ void MainWindow::setupUi()
     connect(openBtn_, &QPushButton::clicked, this, &MainWindow::openSerial);
     connect(closeBtn_, &QPushButton::clicked, this, &MainWindow::closeSerial);
     connect(sendBtn_, &QPushButton::clicked, this, &MainWindow::sendCommand);
+    connect(sessionList_, &QListWidget::currentItemChanged, this, [this](QListWidgetItem *item) {
+        for (PortSession *session : sessions_) {
+            if (session->item == item)
+                setActiveSession(session);
+        }
+    });
+    connect(sessionList_, &QListWidget::itemChanged, this, [this](QListWidgetItem *item) {
+        for (PortSession *session : sessions_) {
+            if (session->item == item && session->shown != (item->checkState() == Qt::Checked)) {
+                session->shown = (item->checkState() == Qt::Checked);
+                applyLogFilter();
+            }
+        }
+    });
     connect(cmdLoadBtn_, &QPushButton::clicked, this, &MainWindow::loadCommands);
     connect(clearBtn_, &QPushButton::clicked, this, &MainWindow::clearLog);
     connect(searchUpBtn_, &QPushButton::clicked, this, &MainWindow::searchUp);
     connect(searchDownBtn_, &QPushButton::clicked, this, &MainWindow::searchDown);
     connect(autoScrollCheck_, &QCheckBox::stateChanged, this, [this](int state) {
         autoScrollEnabled_ = (state == Qt::Checked);
-    });
-    connect(logReadOnlyCheck_, &QCheckBox::stateChanged, this, [this](int state) {
-        logView_->setReadOnly(state == Qt::Checked);
+        logView_->setAutoScroll(autoScrollEnabled_);
     });
     connect(spaceBtn_, &QPushButton::clicked, this, [this] () {
         this->log("======================================================\n\n\n");
     });
+    connect(noteBtn_, &QPushButton::clicked, this, &MainWindow::addNote);
     connect(commandLine_, &QLineEdit::returnPressed, this, &MainWindow::sendCommand);
     connect(searchLine_, &QLineEdit::textChanged, this, &MainWindow::updateCompleter);
     connect(searchLine_, &QLineEdit::textChanged, this, &MainWindow::updateSearchMatches);
@@ -419,6 +468,36 @@ void MainWindow::setupUi()
 
     // Connect batch-send button
     connect(sendAllBtn_, &QPushButton::clicked, this, &MainWindow::sendAllCommands);
+    connect(batchPauseBtn_, &QPushButton::clicked, this, [this]() {
+        if (batch_->isPaused()) {
+            batch_->resume();
+            batchPauseBtn_->setText(tr("Pause"));
+        } else {
+            batch_->pause();
+            batchPauseBtn_->setText(tr("Resume"));
+        }
+    });
+    connect(batchCancelBtn_, &QPushButton::clicked, this, [this]() { batch_->cancel(); });
+    // Scheduler signals come from its own thread and are queued to the GUI
+    connect(batch_, &BatchScheduler::progress, batchProgress_, &QProgressBar::setValue);
+    connect(batch_, &BatchScheduler::message, this, [this](const QString &text) { log(text); });
+    connect(batch_, &BatchScheduler::commandSent, this,
+            [this](const QString &text, const QByteArray &payload, qint64 scheduledNs, qint64 actualNs, bool ok) {
+        if (!ok)
+            return;
+        captureTx(batch_->worker(), actualNs, payload);
+        // Scheduled and actual send time from the start of the script
+        QString cmd = text;
+        while (cmd.endsWith('\n') || cmd.endsWith('\r'))
+            cmd.chop(1);
+        const qint64 startNs = batch_->startNs();
+        log(QString("%1%2 (sched +%3 ms, actual +%4 ms, jitter %5 us)\n")
+                .arg(QString(batchHex_ ? "TX (HEX): " : "TX: "), cmd)
+                .arg((scheduledNs - startNs) / 1e6, 0, 'f', 3)
+                .arg((actualNs - startNs) / 1e6, 0, 'f', 3)
+                .arg((actualNs - scheduledNs) / 1000));
+    });
+    connect(batch_, &BatchScheduler::finished, this, &MainWindow::onBatchFinished);
 
     // Keyboard shortcuts for search navigation: F3 = next, Shift+F3 = previous
     QShortcut *next = new QShortcut(QKeySequence("F3"), this);
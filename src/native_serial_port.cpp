@@ -0,0 +1,414 @@
+#include "native_serial_port.h"
+
+#ifdef Q_OS_LINUX
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/serial.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <unistd.h>
+#endif
+
+NativeSerialPort::~NativeSerialPort()
+{
+    close();
+}
+
+#ifdef Q_OS_LINUX
+
+// Kernel termios2 layout for arbitrary baud rates (BOTHER). Declared here
+// because <asm/termbits.h> clashes with glibc's <termios.h>.
+struct LinuxTermios2 {
+    tcflag_t c_iflag;
+    tcflag_t c_oflag;
+    tcflag_t c_cflag;
+    tcflag_t c_lflag;
+    cc_t c_line;
+    cc_t c_cc[19];
+    speed_t c_ispeed;
+    speed_t c_ospeed;
+};
+#ifndef BOTHER
+#define BOTHER 0010000
+#endif
+static const unsigned long kTcGets2 = _IOR('T', 0x2A, LinuxTermios2);
+static const unsigned long kTcSets2 = _IOW('T', 0x2B, LinuxTermios2);
+
+static speed_t toSpeed(int baud)
+{
+    switch (baud) {
+    case 9600: return B9600;
+    case 19200: return B19200;
+    case 38400: return B38400;
+    case 57600: return B57600;
+    case 115200: return B115200;
+    case 230400: return B230400;
+    case 460800: return B460800;
+    case 500000: return B500000;
+    case 576000: return B576000;
+    case 921600: return B921600;
+    case 1000000: return B1000000;
+    case 1152000: return B1152000;
+    case 1500000: return B1500000;
+    case 2000000: return B2000000;
+    case 2500000: return B2500000;
+    case 3000000: return B3000000;
+    case 3500000: return B3500000;
+    case 4000000: return B4000000;
+    default: return B0;
+    }
+}
+
+void NativeSerialPort::fail(const QString &what)
+{
+    error_ = QString("%1: %2").arg(what, QString::fromLocal8Bit(strerror(errno)));
+}
+
+bool NativeSerialPort::open(const QString &portName, int baudrate, const Options &opts,
+                            ReadHandler onRead, ErrorHandler onError)
+{
+    close();
+    error_.clear();
+    opts_ = opts;
+    onRead_ = std::move(onRead);
+    onError_ = std::move(onError);
+
+    if (baudrate <= 0) {
+        error_ = QString("Invalid baud rate %1").arg(baudrate);
+        return false;
+    }
+    speed_t speed = toSpeed(baudrate);
+
+    QString path = portName.startsWith('/') ? portName : "/dev/" + portName;
+    fd_ = ::open(path.toLocal8Bit().constData(), O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+    if (fd_ < 0) {
+        fail(path);
+        return false;
+    }
+    ioctl(fd_, TIOCEXCL);
+
+    // Raw 8N1, optional RTS/CTS
+    termios tio;
+    if (tcgetattr(fd_, &tio) != 0) {
+        fail("tcgetattr");
+        close();
+        return false;
+    }
+    cfmakeraw(&tio);
+    tio.c_cflag |= CLOCAL | CREAD;
+    tio.c_cflag &= ~(CSTOPB | PARENB | CRTSCTS);
+    if (opts_.hardwareFlowControl)
+        tio.c_cflag |= CRTSCTS;
+    tio.c_iflag &= ~(IXON | IXOFF | IXANY);
+    // Readable on the first byte: with VTIME 0 the tty only polls readable
+    // once VMIN bytes are in. VMIN/VTIME are applied by deliver() instead.
+    tio.c_cc[VMIN] = 1;
+    tio.c_cc[VTIME] = 0;
+    // Non-standard rates are set below; start from a valid placeholder
+    cfsetispeed(&tio, speed != B0 ? speed : B38400);
+    cfsetospeed(&tio, speed != B0 ? speed : B38400);
+    if (tcsetattr(fd_, TCSANOW, &tio) != 0) {
+        fail("tcsetattr");
+        close();
+        return false;
+    }
+    if (speed == B0 && !setCustomBaudRate(baudrate)) {
+        close();
+        return false;
+    }
+
+    // Ask the driver to push received bytes up immediately (e.g. FTDI latency
+    // timer). Not all drivers, and no pty, support this; ignore failures.
+    lowLatencyActive_ = false;
+    if (opts_.lowLatency) {
+        serial_struct ss;
+        if (ioctl(fd_, TIOCGSERIAL, &ss) == 0) {
+            ss.flags |= ASYNC_LOW_LATENCY;
+            lowLatencyActive_ = ioctl(fd_, TIOCSSERIAL, &ss) == 0;
+        }
+    }
+    tcflush(fd_, TCIOFLUSH);
+
+    epollFd_ = epoll_create1(EPOLL_CLOEXEC);
+    wakeFd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    txFd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epollFd_ < 0 || wakeFd_ < 0 || txFd_ < 0) {
+        fail("epoll");
+        close();
+        return false;
+    }
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.fd = fd_;
+    epoll_ctl(epollFd_, EPOLL_CTL_ADD, fd_, &ev);
+    ev.data.fd = wakeFd_;
+    epoll_ctl(epollFd_, EPOLL_CTL_ADD, wakeFd_, &ev);
+    ev.data.fd = txFd_;
+    epoll_ctl(epollFd_, EPOLL_CTL_ADD, txFd_, &ev);
+
+    scratch_.resize(size_t(qMax(4096, opts_.readChunkSize)));
+    reader_ = QThread::create([this]() { readLoop(); });
+    reader_->setObjectName("SerialNativeRX");
+    reader_->start(QThread::TimeCriticalPriority);
+    return true;
+}
+
+bool NativeSerialPort::setCustomBaudRate(int baudrate)
+{
+    LinuxTermios2 tio2;
+    if (ioctl(fd_, kTcGets2, &tio2) != 0) {
+        fail("TCGETS2");
+        return false;
+    }
+    tio2.c_cflag &= ~CBAUD;
+    tio2.c_cflag |= BOTHER;
+    tio2.c_ispeed = speed_t(baudrate);
+    tio2.c_ospeed = speed_t(baudrate);
+    if (ioctl(fd_, kTcSets2, &tio2) != 0) {
+        fail(QString("Baud rate %1").arg(baudrate));
+        return false;
+    }
+    return true;
+}
+
+void NativeSerialPort::close()
+{
+    if (reader_) {
+        quint64 one = 1;
+        ssize_t r = ::write(wakeFd_, &one, sizeof(one));
+        Q_UNUSED(r);
+        reader_->wait();
+        delete reader_;
+        reader_ = nullptr;
+    }
+    if (epollFd_ >= 0)
+        ::close(epollFd_);
+    if (wakeFd_ >= 0)
+        ::close(wakeFd_);
+    if (txFd_ >= 0)
+        ::close(txFd_);
+    if (fd_ >= 0)
+        ::close(fd_);
+    epollFd_ = wakeFd_ = txFd_ = fd_ = -1;
+    lowLatencyActive_ = false;
+}
+
+void NativeSerialPort::readLoop()
+{
+    // The tty polls readable on the first byte and the O_NONBLOCK read()
+    // returns what is there; the VMIN grouping is done here, and the wait
+    // is always bounded so a group short of VMIN still goes out when the
+    // line goes quiet.
+    held_.clear();
+    epoll_event events[3];
+
+    while (true) {
+        int timeoutMs = kPollMs;
+        if (!held_.empty()) {
+            if (heldUntil_.hasExpired())
+                flushHeld();
+            else
+                timeoutMs = int(qMin<qint64>(timeoutMs, heldUntil_.remainingTime()));
+        }
+        int n = epoll_wait(epollFd_, events, 3, timeoutMs);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            fail("epoll_wait");
+            if (onError_)
+                onError_(error_);
+            return;
+        }
+        if (n == 0) {
+            if (!drainInput())
+                return;
+            continue;
+        }
+        for (int i = 0; i < n; ++i) {
+            if (events[i].data.fd == wakeFd_)
+                return;
+            if (events[i].data.fd == txFd_) {
+                quint64 count;
+                ssize_t r = ::read(txFd_, &count, sizeof(count));
+                Q_UNUSED(r);
+                if (onWritable_)
+                    onWritable_();
+                continue;
+            }
+            if (events[i].events & EPOLLOUT) {
+                // One-shot: go back to read-only interest before writing more
+                epoll_event ev{};
+                ev.events = EPOLLIN;
+                ev.data.fd = fd_;
+                epoll_ctl(epollFd_, EPOLL_CTL_MOD, fd_, &ev);
+                if (onWritable_)
+                    onWritable_();
+            }
+            if (!drainInput())
+                return;
+            if (events[i].events & (EPOLLHUP | EPOLLERR)) {
+                flushHeld();
+                error_ = "Serial device disconnected";
+                if (onError_)
+                    onError_(error_);
+                return;
+            }
+        }
+    }
+}
+
+bool NativeSerialPort::drainInput()
+{
+    while (true) {
+        ssize_t r = ::read(fd_, scratch_.data(), scratch_.size());
+        if (r > 0) {
+            deliver(scratch_.data(), qint64(r));
+            continue;
+        }
+        if (r < 0 && errno == EINTR)
+            continue;
+        if (r < 0 && errno == EAGAIN)
+            return true;
+        // r == 0 or a real error: the device went away
+        flushHeld();
+        fail("read");
+        if (onError_)
+            onError_(error_);
+        return false;
+    }
+}
+
+void NativeSerialPort::deliver(const char *data, qint64 len)
+{
+    if (opts_.vmin <= 1 || qint64(held_.size()) + len >= opts_.vmin) {
+        if (held_.empty()) {
+            if (onRead_)
+                onRead_(data, len);
+            return;
+        }
+        held_.insert(held_.end(), data, data + len);
+        flushHeld();
+        return;
+    }
+    // Like VTIME, the gap counts from the last byte received
+    held_.insert(held_.end(), data, data + len);
+    heldUntil_.setRemainingTime(opts_.vtime > 0 ? opts_.vtime * 100 : kTailMs, Qt::PreciseTimer);
+}
+
+void NativeSerialPort::flushHeld()
+{
+    if (held_.empty())
+        return;
+    if (onRead_)
+        onRead_(held_.data(), qint64(held_.size()));
+    held_.clear();
+}
+
+qint64 NativeSerialPort::writeSome(const char *data, qint64 len)
+{
+    if (fd_ < 0)
+        return -1;
+    while (true) {
+        ssize_t w = ::write(fd_, data, size_t(len));
+        if (w >= 0)
+            return qint64(w);
+        if (errno == EINTR)
+            continue;
+        if (errno == EAGAIN)
+            return 0;
+        fail("write");
+        return -1;
+    }
+}
+
+void NativeSerialPort::kickWriter()
+{
+    if (txFd_ < 0)
+        return;
+    quint64 one = 1;
+    ssize_t r = ::write(txFd_, &one, sizeof(one));
+    Q_UNUSED(r);
+}
+
+void NativeSerialPort::requestWritable()
+{
+    if (fd_ < 0)
+        return;
+    epoll_event ev{};
+    ev.events = EPOLLIN | EPOLLOUT;
+    ev.data.fd = fd_;
+    epoll_ctl(epollFd_, EPOLL_CTL_MOD, fd_, &ev);
+}
+
+void NativeSerialPort::clear(bool input, bool output)
+{
+    if (fd_ < 0)
+        return;
+    if (input && output)
+        tcflush(fd_, TCIOFLUSH);
+    else if (input)
+        tcflush(fd_, TCIFLUSH);
+    else if (output)
+        tcflush(fd_, TCOFLUSH);
+}
+
+#else // !Q_OS_LINUX
+
+bool NativeSerialPort::open(const QString &, int, const Options &, ReadHandler, ErrorHandler)
+{
+    error_ = "Native serial backend is only available on Linux";
+    return false;
+}
+
+void NativeSerialPort::close()
+{
+}
+
+qint64 NativeSerialPort::writeSome(const char *, qint64)
+{
+    return -1;
+}
+
+void NativeSerialPort::kickWriter()
+{
+}
+
+void NativeSerialPort::requestWritable()
+{
+}
+
+void NativeSerialPort::clear(bool, bool)
+{
+}
+
+void NativeSerialPort::readLoop()
+{
+}
+
+bool NativeSerialPort::drainInput()
+{
+    return false;
+}
+
+void NativeSerialPort::deliver(const char *, qint64)
+{
+}
+
+void NativeSerialPort::flushHeld()
+{
+}
+
+void NativeSerialPort::fail(const QString &what)
+{
+    error_ = what;
+}
+
+bool NativeSerialPort::setCustomBaudRate(int)
+{
+    return false;
+}
+
+#endif
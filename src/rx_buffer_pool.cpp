@@ -0,0 +1,140 @@
+#include "rx_buffer_pool.h"
+#include <QMutexLocker>
+
+// ----- RxChunk -----
+
+RxChunk::RxChunk(RxBlock *block, int offset, int size, qint64 timestampNs)
+    : block_(block), offset_(offset), size_(size), timestampNs_(timestampNs)
+{
+}
+
+RxChunk::RxChunk(const RxChunk &other)
+    : block_(other.block_), offset_(other.offset_), size_(other.size_), timestampNs_(other.timestampNs_)
+{
+    if (block_)
+        block_->ref.ref();
+}
+
+RxChunk::RxChunk(RxChunk &&other) noexcept
+    : block_(other.block_), offset_(other.offset_), size_(other.size_), timestampNs_(other.timestampNs_)
+{
+    other.block_ = nullptr;
+    other.size_ = 0;
+}
+
+RxChunk &RxChunk::operator=(const RxChunk &other)
+{
+    if (this != &other) {
+        if (other.block_)
+            other.block_->ref.ref();
+        release();
+        block_ = other.block_;
+        offset_ = other.offset_;
+        size_ = other.size_;
+        timestampNs_ = other.timestampNs_;
+    }
+    return *this;
+}
+
+RxChunk &RxChunk::operator=(RxChunk &&other) noexcept
+{
+    if (this != &other) {
+        release();
+        block_ = other.block_;
+        offset_ = other.offset_;
+        size_ = other.size_;
+        timestampNs_ = other.timestampNs_;
+        other.block_ = nullptr;
+        other.size_ = 0;
+    }
+    return *this;
+}
+
+RxChunk::~RxChunk()
+{
+    release();
+}
+
+RxChunk RxChunk::mid(int pos, int len) const
+{
+    if (!block_ || pos < 0 || pos > size_)
+        return RxChunk();
+    len = qMin(len, size_ - pos);
+    block_->ref.ref();
+    return RxChunk(block_, offset_ + pos, len, timestampNs_);
+}
+
+void RxChunk::release()
+{
+    if (block_ && !block_->ref.deref())
+        RxBufferPool::instance().recycle(block_);
+    block_ = nullptr;
+    size_ = 0;
+}
+
+// ----- RxBufferPool -----
+
+RxBufferPool &RxBufferPool::instance()
+{
+    // Enough blocks for a few frames of backlog across several ports
+    static RxBufferPool pool(8);
+    return pool;
+}
+
+RxBufferPool::RxBufferPool(int preallocate)
+{
+    for (int i = 0; i < preallocate; ++i) {
+        RxBlock *b = new RxBlock;
+        b->next = free_;
+        free_ = b;
+        ++stats_.totalBlocks;
+    }
+}
+
+RxBufferPool::~RxBufferPool()
+{
+    while (free_) {
+        RxBlock *b = free_;
+        free_ = b->next;
+        delete b;
+    }
+}
+
+RxBlock *RxBufferPool::acquire()
+{
+    QMutexLocker lock(&mutex_);
+    RxBlock *b = free_;
+    if (b) {
+        free_ = b->next;
+    } else {
+        b = new RxBlock;
+        ++stats_.totalBlocks;
+        ++stats_.misses;
+    }
+    b->next = nullptr;
+    b->ref.storeRelaxed(1);
+    ++stats_.acquires;
+    ++stats_.inUse;
+    stats_.peakInUse = qMax(stats_.peakInUse, stats_.inUse);
+    return b;
+}
+
+RxChunk RxBufferPool::wrap(RxBlock *block, int len, qint64 timestampNs)
+{
+    // The reference taken by acquire() is handed over to the chunk
+    return RxChunk(block, 0, qBound(0, len, RxBlock::kSize), timestampNs);
+}
+
+void RxBufferPool::recycle(RxBlock *block)
+{
+    QMutexLocker lock(&mutex_);
+    block->next = free_;
+    free_ = block;
+    --stats_.inUse;
+}
+
+RxBufferPool::Stats RxBufferPool::stats() const
+{
+    QMutexLocker lock(&mutex_);
+    return stats_;
+}
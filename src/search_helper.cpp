@@ -1,4 +1,12 @@
 #include "search_helper.h"
+#include <atomic>
+#include <cstring>
+#include <string>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SEARCH_HELPER_X86 1
+#include <immintrin.h>
+#endif
 
 namespace SearchHelper {
 
@@ -34,3 +42,312 @@ int findPrevious(const QString &text, const QString &term, int from, Qt::CaseSen
 }
 
 } // namespace SearchHelper
+
+// ---------------------------------------------------------------------------
+// Byte search engine
+//
+// The SIMD paths compare the needle's first and last byte against a whole
+// block of candidate positions at once and only verify the few positions
+// where both agree (the "generic SIMD" substring filter). Case-insensitive
+// search folds A-Z in the block before comparing.
+
+namespace {
+
+struct Pattern {
+    const char *data;
+    int size;
+    bool fold;
+    bool words;
+    std::string folded;     // needle with A-Z folded, if fold
+    unsigned char first;
+    unsigned char last;
+};
+
+inline unsigned char foldByte(unsigned char c)
+{
+    return (c >= 'A' && c <= 'Z') ? c | 0x20 : c;
+}
+
+inline bool isWordByte(unsigned char c)
+{
+    return c >= 0x80 || c == '_' || (c >= '0' && c <= '9') || (foldByte(c) >= 'a' && foldByte(c) <= 'z');
+}
+
+Pattern makePattern(const char *needle, int len, int options)
+{
+    Pattern pat;
+    pat.data = needle;
+    pat.size = len;
+    pat.fold = options & SearchHelper::CaseInsensitive;
+    pat.words = options & SearchHelper::WholeWords;
+    if (pat.fold) {
+        pat.folded.assign(needle, size_t(len));
+        for (char &c : pat.folded)
+            c = char(foldByte(uchar(c)));
+        pat.data = pat.folded.data();
+    }
+    pat.first = uchar(pat.data[0]);
+    pat.last = uchar(pat.data[len - 1]);
+    return pat;
+}
+
+// Full check of a candidate whose first and last bytes already matched
+inline bool matchesAt(const Pattern &pat, const char *begin, const char *end, const char *p)
+{
+    if (pat.fold) {
+        for (int i = 1; i < pat.size - 1; ++i) {
+            if (foldByte(uchar(p[i])) != uchar(pat.data[i]))
+                return false;
+        }
+    } else if (pat.size > 2 && memcmp(p + 1, pat.data + 1, size_t(pat.size - 2)) != 0) {
+        return false;
+    }
+    if (pat.words) {
+        if (p > begin && isWordByte(uchar(p[-1])))
+            return false;
+        if (p + pat.size < end && isWordByte(uchar(p[pat.size])))
+            return false;
+    }
+    return true;
+}
+
+inline bool candidateAt(const Pattern &pat, const char *p)
+{
+    if (pat.fold)
+        return foldByte(uchar(p[0])) == pat.first && foldByte(uchar(p[pat.size - 1])) == pat.last;
+    return uchar(p[0]) == pat.first && uchar(p[pat.size - 1]) == pat.last;
+}
+
+// Candidates start in [from, to); every match must end by end
+const char *scanForward(const Pattern &pat, const char *begin, const char *end, const char *from, const char *to)
+{
+    if (!pat.fold) {
+        for (const char *p = from; p < to; ++p) {
+            p = static_cast<const char *>(memchr(p, pat.first, size_t(to - p)));
+            if (!p)
+                return nullptr;
+            if (candidateAt(pat, p) && matchesAt(pat, begin, end, p))
+                return p;
+        }
+        return nullptr;
+    }
+    for (const char *p = from; p < to; ++p) {
+        if (candidateAt(pat, p) && matchesAt(pat, begin, end, p))
+            return p;
+    }
+    return nullptr;
+}
+
+const char *scanBackward(const Pattern &pat, const char *begin, const char *end, const char *from, const char *to)
+{
+    for (const char *p = to; p > from;) {
+        --p;
+        if (candidateAt(pat, p) && matchesAt(pat, begin, end, p))
+            return p;
+    }
+    return nullptr;
+}
+
+const char *findScalar(const Pattern &pat, const char *begin, const char *end)
+{
+    return scanForward(pat, begin, end, begin, end - pat.size + 1);
+}
+
+const char *findLastScalar(const Pattern &pat, const char *begin, const char *end)
+{
+    return scanBackward(pat, begin, end, begin, end - pat.size + 1);
+}
+
+#ifdef SEARCH_HELPER_X86
+
+__attribute__((target("sse2"))) inline __m128i fold16(__m128i x)
+{
+    const __m128i upper = _mm_and_si128(_mm_cmpgt_epi8(x, _mm_set1_epi8('A' - 1)),
+                                        _mm_cmplt_epi8(x, _mm_set1_epi8('Z' + 1)));
+    return _mm_or_si128(x, _mm_and_si128(upper, _mm_set1_epi8(0x20)));
+}
+
+// Bit i set if position p + i is a candidate
+__attribute__((target("sse2"))) inline unsigned mask16(const Pattern &pat, const char *p)
+{
+    __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+    __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + pat.size - 1));
+    if (pat.fold) {
+        a = fold16(a);
+        b = fold16(b);
+    }
+    const __m128i eq = _mm_and_si128(_mm_cmpeq_epi8(a, _mm_set1_epi8(char(pat.first))),
+                                     _mm_cmpeq_epi8(b, _mm_set1_epi8(char(pat.last))));
+    return unsigned(_mm_movemask_epi8(eq));
+}
+
+__attribute__((target("sse2"))) const char *findSse2(const Pattern &pat, const char *begin, const char *end)
+{
+    const char *stop = end - pat.size + 1;   // one past the last candidate
+    const char *p = begin;
+    for (; stop - p >= 16; p += 16) {
+        for (unsigned mask = mask16(pat, p); mask; mask &= mask - 1) {
+            const char *c = p + __builtin_ctz(mask);
+            if (matchesAt(pat, begin, end, c))
+                return c;
+        }
+    }
+    return scanForward(pat, begin, end, p, stop);
+}
+
+__attribute__((target("sse2"))) const char *findLastSse2(const Pattern &pat, const char *begin, const char *end)
+{
+    const char *q = end - pat.size + 1;
+    for (; q - begin >= 16; q -= 16) {
+        const char *p = q - 16;
+        for (unsigned mask = mask16(pat, p); mask;) {
+            const int bit = 31 - __builtin_clz(mask);
+            if (matchesAt(pat, begin, end, p + bit))
+                return p + bit;
+            mask &= ~(1u << bit);
+        }
+    }
+    return scanBackward(pat, begin, end, begin, q);
+}
+
+__attribute__((target("avx2"))) inline __m256i fold32(__m256i x)
+{
+    const __m256i upper = _mm256_and_si256(_mm256_cmpgt_epi8(x, _mm256_set1_epi8('A' - 1)),
+                                           _mm256_cmpgt_epi8(_mm256_set1_epi8('Z' + 1), x));
+    return _mm256_or_si256(x, _mm256_and_si256(upper, _mm256_set1_epi8(0x20)));
+}
+
+__attribute__((target("avx2"))) inline unsigned mask32(const Pattern &pat, const char *p)
+{
+    __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+    __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + pat.size - 1));
+    if (pat.fold) {
+        a = fold32(a);
+        b = fold32(b);
+    }
+    const __m256i eq = _mm256_and_si256(_mm256_cmpeq_epi8(a, _mm256_set1_epi8(char(pat.first))),
+                                        _mm256_cmpeq_epi8(b, _mm256_set1_epi8(char(pat.last))));
+    return unsigned(_mm256_movemask_epi8(eq));
+}
+
+__attribute__((target("avx2"))) const char *findAvx2(const Pattern &pat, const char *begin, const char *end)
+{
+    const char *stop = end - pat.size + 1;
+    const char *p = begin;
+    for (; stop - p >= 32; p += 32) {
+        for (unsigned mask = mask32(pat, p); mask; mask &= mask - 1) {
+            const char *c = p + __builtin_ctz(mask);
+            if (matchesAt(pat, begin, end, c))
+                return c;
+        }
+    }
+    return scanForward(pat, begin, end, p, stop);
+}
+
+__attribute__((target("avx2"))) const char *findLastAvx2(const Pattern &pat, const char *begin, const char *end)
+{
+    const char *q = end - pat.size + 1;
+    for (; q - begin >= 32; q -= 32) {
+        const char *p = q - 32;
+        for (unsigned mask = mask32(pat, p); mask;) {
+            const int bit = 31 - __builtin_clz(mask);
+            if (matchesAt(pat, begin, end, p + bit))
+                return p + bit;
+            mask &= ~(1u << bit);
+        }
+    }
+    return scanBackward(pat, begin, end, begin, q);
+}
+
+#endif // SEARCH_HELPER_X86
+
+struct Backend {
+    const char *(*find)(const Pattern &, const char *, const char *);
+    const char *(*findLast)(const Pattern &, const char *, const char *);
+    const char *name;
+};
+
+// Fastest first
+const Backend kBackends[] = {
+#ifdef SEARCH_HELPER_X86
+    {findAvx2, findLastAvx2, "AVX2"},
+    {findSse2, findLastSse2, "SSE2"},
+#endif
+    {findScalar, findLastScalar, "scalar"},
+};
+
+bool supported(const Backend &b)
+{
+#ifdef SEARCH_HELPER_X86
+    __builtin_cpu_init();
+    if (b.find == findAvx2)
+        return __builtin_cpu_supports("avx2");
+    if (b.find == findSse2)
+        return __builtin_cpu_supports("sse2");
+#endif
+    return b.find == findScalar;
+}
+
+// Picked once at runtime; setBackend() may swap it
+std::atomic<const Backend *> &current()
+{
+    static std::atomic<const Backend *> selected{[]() -> const Backend * {
+        for (const Backend &b : kBackends) {
+            if (supported(b))
+                return &b;
+        }
+        return nullptr;
+    }()};
+    return selected;
+}
+
+const Backend &backend()
+{
+    return *current().load(std::memory_order_relaxed);
+}
+
+} // namespace
+
+namespace SearchHelper {
+
+const char *find(const char *begin, const char *end, const char *needle, int needleLen, int options)
+{
+    if (needleLen <= 0 || end - begin < needleLen)
+        return nullptr;
+    return backend().find(makePattern(needle, needleLen, options), begin, end);
+}
+
+const char *findLast(const char *begin, const char *end, const char *needle, int needleLen, int options)
+{
+    if (needleLen <= 0 || end - begin < needleLen)
+        return nullptr;
+    return backend().findLast(makePattern(needle, needleLen, options), begin, end);
+}
+
+const char *backendName()
+{
+    return backend().name;
+}
+
+QStringList backends()
+{
+    QStringList names;
+    for (const Backend &b : kBackends) {
+        if (supported(b))
+            names << QString::fromLatin1(b.name);
+    }
+    return names;
+}
+
+bool setBackend(const QString &name)
+{
+    for (const Backend &b : kBackends) {
+        if (name == QLatin1String(b.name) && supported(b)) {
+            current().store(&b, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace SearchHelper
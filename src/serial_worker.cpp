@@ -1,64 +1,378 @@
 #include "serial_worker.h"
 #include <QDebug>
+#include <QTimer>
+#include <chrono>
+
+static const int kReadChunkSize = 64 * 1024;
+// Throughput mode: ~1/4 s of backlog at 12 Mbaud, and 1 MiB reads
+static const int kThroughputReadChunkSize = 1024 * 1024;
+static const qint64 kRingCapacity = 4 * 1024 * 1024;
+static const qint64 kThroughputRingCapacity = 32 * 1024 * 1024;
+// Bytes handed to QSerialPort ahead of confirmation, and per write() call
+static const qint64 kTxInFlight = 64 * 1024;
+
+qint64 SerialWorker::monotonicNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
 
 SerialWorker::SerialWorker(QObject *parent)
     : QObject(parent)
 {
-    connect(&serial_, &QSerialPort::readyRead, this, &SerialWorker::handleReadyRead);
+    // Frame clock for FramePaced delivery; only runs while data is flowing
+    frameTimer_ = new QTimer(this);
+    frameTimer_->setTimerType(Qt::PreciseTimer);
+    frameTimer_->setInterval(16);
+    connect(frameTimer_, &QTimer::timeout, this, &SerialWorker::onFrameTick);
+
+    ioThread_.setObjectName("SerialIO");
+    io_ = new QObject;
+    io_->moveToThread(&ioThread_);
+    ioThread_.start(QThread::TimeCriticalPriority);
+
+    // Create the port on the I/O thread so its notifiers belong to that thread
+    QMetaObject::invokeMethod(io_, [this]() {
+        serial_ = new QSerialPort(io_);
+        readScratch_.resize(kReadChunkSize);
+        connect(serial_, &QSerialPort::readyRead, io_, [this]() { handleReadyRead(); });
+        connect(serial_, &QSerialPort::bytesWritten, io_, [this](qint64 n) {
+            txWritten_.fetch_add(quint64(n), std::memory_order_relaxed);
+            drainTx();
+        });
+    }, Qt::BlockingQueuedConnection);
+    txScratch_.resize(int(kTxInFlight));
+    native_.setWritableHandler([this]() { drainTx(); });
 }
 
 SerialWorker::~SerialWorker()
 {
-    if (serial_.isOpen())
-        serial_.close();
+    native_.close();
+    QMetaObject::invokeMethod(io_, [this]() {
+        if (serial_->isOpen())
+            serial_->close();
+        delete serial_;
+        serial_ = nullptr;
+    }, Qt::BlockingQueuedConnection);
+    ioThread_.quit();
+    ioThread_.wait();
+    delete io_;
 }
 
-bool SerialWorker::openPort(const QString &portName, int baudrate)
+bool SerialWorker::openPort(const QString &portName, int baudrate, Backend backend)
 {
-    if (serial_.isOpen())
-        serial_.close();
+    PortSettings settings;
+    settings.baudRate = baudrate;
+    settings.backend = backend;
+    return openPort(portName, settings);
+}
 
-    serial_.setPortName(portName);
-    serial_.setBaudRate(baudrate);
-    serial_.setDataBits(QSerialPort::Data8);
-    serial_.setParity(QSerialPort::NoParity);
-    serial_.setStopBits(QSerialPort::OneStop);
-    serial_.setFlowControl(QSerialPort::NoFlowControl);
+bool SerialWorker::openPort(const QString &portName, const PortSettings &settings)
+{
+    closePort();
+    backend_ = settings.backend;
 
-    if (serial_.open(QIODevice::ReadWrite)) {
-        emit portOpened();
-        return true;
-    } else {
-        emit errorOccurred(serial_.errorString());
-        return false;
+    // Both sides of the ring are idle here, so it can be resized safely
+    const qint64 ringCapacity = settings.throughputMode ? kThroughputRingCapacity : kRingCapacity;
+    if (rxRing_.capacity() != ringCapacity)
+        rxRing_.resize(ringCapacity);
+    rxRing_.clear();
+    rxMarks_.reset();
+    txRing_.clear();
+    txOverflow_.clear();
+    txOverflowPos_ = 0;
+    txOverflowLeft_.store(0);
+    txBlocked_.store(false);
+    const int readChunk = settings.throughputMode ? kThroughputReadChunkSize : kReadChunkSize;
+
+    if (settings.backend == Backend::NativeLinux) {
+        NativeSerialPort::Options opts = nativeOpts_;
+        opts.hardwareFlowControl = settings.hardwareFlowControl;
+        opts.readChunkSize = readChunk;
+        bool ok = native_.open(portName, settings.baudRate, opts,
+                               [this](const char *data, qint64 len) { onBytesRead(data, len); },
+                               [this](const QString &msg) {
+                                   open_.store(false);
+                                   emit errorOccurred(msg);
+                               });
+        open_.store(ok);
+        if (ok) {
+            rxRing_.resetStats();
+            emit portOpened();
+        } else {
+            emit errorOccurred(native_.errorString());
+        }
+        return ok;
     }
+
+    bool ok = false;
+    QMetaObject::invokeMethod(io_, [&]() {
+        readScratch_.resize(readChunk);
+        serial_->setPortName(portName);
+        serial_->setDataBits(QSerialPort::Data8);
+        serial_->setParity(QSerialPort::NoParity);
+        serial_->setStopBits(QSerialPort::OneStop);
+        serial_->setFlowControl(settings.hardwareFlowControl ? QSerialPort::HardwareControl
+                                                             : QSerialPort::NoFlowControl);
+        // Unbounded internal buffer: we drain it on every readyRead anyway
+        serial_->setReadBufferSize(0);
+
+        ok = serial_->open(QIODevice::ReadWrite);
+        // Custom rates are only accepted once the port is open on some platforms
+        if (ok && !serial_->setBaudRate(settings.baudRate)) {
+            emit errorOccurred(QString("Baud rate %1: %2").arg(settings.baudRate).arg(serial_->errorString()));
+            serial_->close();
+            ok = false;
+            return;
+        }
+        open_.store(ok);
+        if (ok)
+            emit portOpened();
+        else
+            emit errorOccurred(serial_->errorString());
+    }, Qt::BlockingQueuedConnection);
+
+    if (ok)
+        rxRing_.resetStats();
+    return ok;
 }
 
 void SerialWorker::closePort()
 {
-    if (serial_.isOpen()) {
-        serial_.close();
+    if (native_.isOpen()) {
+        native_.close();
+        open_.store(false);
         emit portClosed();
+        return;
     }
+    QMetaObject::invokeMethod(io_, [this]() {
+        if (serial_->isOpen()) {
+            serial_->close();
+            open_.store(false);
+            emit portClosed();
+        }
+    }, Qt::BlockingQueuedConnection);
 }
 
 bool SerialWorker::sendData(const QByteArray &data)
 {
-    if (!serial_.isOpen())
+    if (!isOpen())
+        return false;
+    if (data.isEmpty())
+        return true;
+
+    // The TX ring has a single producer slot; serialize callers
+    QMutexLocker lock(&txProducerMutex_);
+
+    // Backpressure: refuse whole messages rather than splitting them. One
+    // larger than the high-water mark could never pass that test, so it is
+    // taken as soon as the queue is empty; what does not fit the ring waits
+    // in txOverflow_ and nothing else is queued behind it until it is in.
+    const qint64 queued = txRing_.size() + txOverflowLeft_.load();
+    const bool oversize = data.size() > txHighWater_;
+    if (oversize ? queued > 0 : (queued + data.size() > txHighWater_ || txOverflowLeft_.load() > 0)) {
+        txBlocked_.store(true);
+        txRejected_.fetch_add(1, std::memory_order_relaxed);
         return false;
-    return serial_.write(data) == data.size();
+    }
+    const qint64 n = qMin<qint64>(data.size(), txRing_.capacity() - txRing_.size());
+    txRing_.write(data.constData(), n);
+    if (n < data.size()) {
+        txOverflow_ = data;
+        txOverflowPos_ = int(n);
+        txOverflowLeft_.store(data.size() - n);
+    }
+    txQueued_.fetch_add(quint64(data.size()), std::memory_order_relaxed);
+
+    // Wake the writer once; small sends queued before it runs are coalesced
+    if (!txKickPending_.exchange(true)) {
+        if (native_.isOpen())
+            native_.kickWriter();
+        else
+            QMetaObject::invokeMethod(io_, [this]() { drainTx(); }, Qt::QueuedConnection);
+    }
+    return true;
+}
+
+void SerialWorker::setTxHighWaterMark(qint64 bytes)
+{
+    txHighWater_ = qBound<qint64>(1024, bytes, txRing_.capacity());
+}
+
+bool SerialWorker::refillTx()
+{
+    if (txOverflowLeft_.load() == 0)
+        return false;
+    // Producer side of the ring for a moment, like sendData()
+    QMutexLocker lock(&txProducerMutex_);
+    const qint64 n = qMin<qint64>(txOverflow_.size() - txOverflowPos_, txRing_.capacity() - txRing_.size());
+    txRing_.write(txOverflow_.constData() + txOverflowPos_, n);
+    txOverflowPos_ += int(n);
+    txOverflowLeft_.store(txOverflow_.size() - txOverflowPos_);
+    if (txOverflowPos_ < txOverflow_.size())
+        return true;
+    txOverflow_.clear();
+    txOverflowPos_ = 0;
+    return false;
+}
+
+void SerialWorker::drainTx()
+{
+    txKickPending_.store(false);
+
+    bool more;
+    do {
+        more = refillTx();
+        drainTxRing();
+        // Emptied while part of an oversize message still waits: go again
+    } while (more && txRing_.size() == 0);
+    onTxProgress();
+}
+
+void SerialWorker::drainTxRing()
+{
+    if (native_.isOpen()) {
+        while (txRing_.size() > 0) {
+            qint64 n = txRing_.peek(txScratch_.data(), txScratch_.size());
+            qint64 w = native_.writeSome(txScratch_.constData(), n);
+            if (w < 0) {
+                emit errorOccurred(native_.errorString());
+                break;
+            }
+            txRing_.skip(w);
+            txWritten_.fetch_add(quint64(w), std::memory_order_relaxed);
+            if (w < n) {
+                // Kernel buffer full: continue when the tty is writable
+                native_.requestWritable();
+                break;
+            }
+        }
+    } else if (serial_ && serial_->isOpen()) {
+        // Keep a bounded amount in QSerialPort's own buffer; bytesWritten
+        // brings us back here as the driver consumes it
+        while (txRing_.size() > 0 && serial_->bytesToWrite() < kTxInFlight) {
+            qint64 n = txRing_.read(txScratch_.data(), kTxInFlight - serial_->bytesToWrite());
+            if (serial_->write(txScratch_.constData(), n) != n) {
+                emit errorOccurred(serial_->errorString());
+                break;
+            }
+        }
+    }
+}
+
+void SerialWorker::onTxProgress()
+{
+    if (txBlocked_.load() && txQueueDepth() <= txHighWater_ / 4) {
+        txBlocked_.store(false);
+        emit txQueueLow();
+    }
 }
 
 void SerialWorker::handleReadyRead()
 {
-    QByteArray data = serial_.readAll();
-    emit dataReceived(data);
+    // Move everything the driver has into the ring without waiting on the
+    // GUI. If the ring is full the excess is dropped and counted.
+    while (true) {
+        qint64 n = serial_->read(readScratch_.data(), readScratch_.size());
+        if (n <= 0)
+            break;
+        onBytesRead(readScratch_.constData(), n);
+    }
+}
+
+void SerialWorker::onBytesRead(const char *data, qint64 len)
+{
+    const qint64 now = monotonicNs();
+    rxBytes_.fetch_add(quint64(len), std::memory_order_relaxed);
+    if (rxRing_.write(data, len) > 0) {
+        // If the mark queue is full the next mark covers these bytes too
+        rxMarks_.push({rxRing_.totalWritten(), now});
+    }
+
+    // Wake the GUI once; further reads before it drains just add to the ring
+    if (!drainPending_.exchange(true))
+        QMetaObject::invokeMethod(this, &SerialWorker::onRxNotify, Qt::QueuedConnection);
+}
+
+void SerialWorker::setFrameInterval(int ms)
+{
+    frameTimer_->setInterval(qMax(1, ms));
+}
+
+int SerialWorker::frameInterval() const
+{
+    return frameTimer_->interval();
+}
+
+void SerialWorker::onRxNotify()
+{
+    if (deliveryMode_ == DeliveryMode::Immediate) {
+        drainRx(0);
+        return;
+    }
+    // First data after idle: deliver on the next frame tick
+    if (!frameTimer_->isActive())
+        frameTimer_->start();
+}
+
+void SerialWorker::onFrameTick()
+{
+    // Stop ticking once the ring runs dry; the next notify restarts the clock
+    if (!drainRx(flushBudget_))
+        frameTimer_->stop();
+}
+
+bool SerialWorker::drainRx(qint64 budget)
+{
+    // Clear the flag first so data written after this point schedules a new drain
+    drainPending_.store(false);
+
+    qint64 avail = rxRing_.size();
+    if (avail <= 0)
+        return false;
+    if (budget > 0)
+        avail = qMin(avail, budget);
+
+    // Copy out of the ring straight into pooled blocks; no per-chunk allocation
+    RxBufferPool &pool = RxBufferPool::instance();
+    while (avail > 0) {
+        // Time stamp = arrival of the read that delivered this chunk's first byte
+        const quint64 start = rxRing_.totalRead();
+        qint64 timestampNs = monotonicNs();
+        RxMark mark;
+        while (rxMarks_.peek(mark)) {
+            if (mark.streamEnd > start) {
+                timestampNs = mark.timestampNs;
+                break;
+            }
+            rxMarks_.pop();
+        }
+
+        RxBlock *block = pool.acquire();
+        qint64 n = rxRing_.read(block->data, qMin<qint64>(avail, RxBlock::kSize));
+        if (n <= 0) {
+            pool.recycle(block);
+            break;
+        }
+        avail -= n;
+        ++deliveries_;
+        emit dataReceived(pool.wrap(block, int(n), timestampNs));
+    }
+    return true;
 }
 
 void SerialWorker::clearBuffer()
 {
-    if (serial_.isOpen()) {
-        serial_.clear(QSerialPort::Input);
-        serial_.clear(QSerialPort::Output);
+    if (native_.isOpen()) {
+        native_.clear(true, true);
+        rxRing_.clear();
+        return;
     }
-}
\ No newline at end of file
+    QMetaObject::invokeMethod(io_, [this]() {
+        if (serial_->isOpen()) {
+            serial_->clear(QSerialPort::Input);
+            serial_->clear(QSerialPort::Output);
+        }
+    }, Qt::BlockingQueuedConnection);
+    rxRing_.clear();
+}
@@ -0,0 +1,115 @@
+#include "spsc_ring_buffer.h"
+#include <algorithm>
+#include <cstring>
+
+static quint64 roundUpPow2(qint64 v)
+{
+    quint64 n = 1;
+    while (n < quint64(qMax<qint64>(v, 2)))
+        n <<= 1;
+    return n;
+}
+
+SpscRingBuffer::SpscRingBuffer(qint64 capacity)
+{
+    resize(capacity);
+}
+
+void SpscRingBuffer::resize(qint64 capacity)
+{
+    quint64 cap = roundUpPow2(capacity);
+    buf_.assign(cap, 0);
+    mask_ = cap - 1;
+    head_.store(0, std::memory_order_relaxed);
+    tail_.store(0, std::memory_order_relaxed);
+    resetStats();
+}
+
+qint64 SpscRingBuffer::size() const
+{
+    quint64 head = head_.load(std::memory_order_acquire);
+    quint64 tail = tail_.load(std::memory_order_acquire);
+    return qint64(head - tail);
+}
+
+qint64 SpscRingBuffer::write(const char *data, qint64 len)
+{
+    if (len <= 0)
+        return 0;
+
+    const quint64 head = head_.load(std::memory_order_relaxed);
+    const quint64 tail = tail_.load(std::memory_order_acquire);
+    const quint64 cap = mask_ + 1;
+    const quint64 free = cap - (head - tail);
+    const quint64 n = std::min<quint64>(free, quint64(len));
+
+    if (n < quint64(len)) {
+        overflows_.fetch_add(1, std::memory_order_relaxed);
+        dropped_.fetch_add(quint64(len) - n, std::memory_order_relaxed);
+    }
+    if (n == 0)
+        return 0;
+
+    // Copy in at most two spans (before and after the wrap point)
+    const quint64 off = head & mask_;
+    const quint64 first = std::min(n, cap - off);
+    std::memcpy(buf_.data() + off, data, first);
+    if (n > first)
+        std::memcpy(buf_.data(), data + first, n - first);
+
+    head_.store(head + n, std::memory_order_release);
+
+    const qint64 used = qint64(head + n - tail);
+    if (used > peak_.load(std::memory_order_relaxed))
+        peak_.store(used, std::memory_order_relaxed);
+    return qint64(n);
+}
+
+qint64 SpscRingBuffer::peek(char *out, qint64 maxLen) const
+{
+    if (maxLen <= 0)
+        return 0;
+
+    const quint64 tail = tail_.load(std::memory_order_relaxed);
+    const quint64 head = head_.load(std::memory_order_acquire);
+    const quint64 cap = mask_ + 1;
+    const quint64 n = std::min<quint64>(head - tail, quint64(maxLen));
+    if (n == 0)
+        return 0;
+
+    const quint64 off = tail & mask_;
+    const quint64 first = std::min(n, cap - off);
+    std::memcpy(out, buf_.data() + off, first);
+    if (n > first)
+        std::memcpy(out + first, buf_.data(), n - first);
+    return qint64(n);
+}
+
+void SpscRingBuffer::skip(qint64 len)
+{
+    if (len <= 0)
+        return;
+    const quint64 tail = tail_.load(std::memory_order_relaxed);
+    const quint64 head = head_.load(std::memory_order_acquire);
+    const quint64 n = std::min<quint64>(head - tail, quint64(len));
+    tail_.store(tail + n, std::memory_order_release);
+}
+
+qint64 SpscRingBuffer::read(char *out, qint64 maxLen)
+{
+    const qint64 n = peek(out, maxLen);
+    skip(n);
+    return n;
+}
+
+void SpscRingBuffer::clear()
+{
+    tail_.store(head_.load(std::memory_order_acquire), std::memory_order_release);
+}
+
+void SpscRingBuffer::resetStats()
+{
+    peak_.store(0, std::memory_order_relaxed);
+    overflows_.store(0, std::memory_order_relaxed);
+    dropped_.store(0, std::memory_order_relaxed);
+}
@@ -0,0 +1,221 @@
+#include "traffic_generator.h"
+#include "serial_worker.h"
+#include <QRandomGenerator>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+#ifdef Q_OS_LINUX
+#include <cerrno>
+#include <cstdlib>
+#include <fcntl.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+TrafficGenerator::~TrafficGenerator()
+{
+    stop();
+}
+
+void TrafficGenerator::setRate(qint64 bytesPerSec)
+{
+    rate_.store(qMax<qint64>(1, bytesPerSec));
+}
+
+void TrafficGenerator::generate(QByteArray &out, qint64 minBytes)
+{
+    char line[160];
+    const qint64 target = out.size() + minBytes;
+    while (out.size() < target) {
+        const quint64 n = seq_++;
+        int len = 0;
+        switch (pattern_) {
+        case Pattern::Text:
+            len = snprintf(line, sizeof(line), "%010llu The quick brown fox jumps over the lazy dog 0123456789\n",
+                           static_cast<unsigned long long>(n));
+            break;
+        case Pattern::Telemetry:
+        case Pattern::Burst: {
+            const double t = double(n) * 0.01;
+            len = snprintf(line, sizeof(line), "temp:%.2f,hum:%.2f,volt:%.3f,seq:%llu\n",
+                           25.0 + 5.0 * std::sin(t), 50.0 + 20.0 * std::cos(t * 0.3),
+                           3.3 + 0.1 * std::sin(t * 7.0), static_cast<unsigned long long>(n));
+            break;
+        }
+        case Pattern::Binary: {
+            quint32 words[16];
+            QRandomGenerator::global()->fillRange(words);
+            memcpy(line, words, sizeof(words));
+            len = int(sizeof(words));
+            break;
+        }
+        }
+        out.append(line, len);
+    }
+}
+
+#ifdef Q_OS_LINUX
+
+void TrafficGenerator::fail(const QString &what)
+{
+    error_ = QString("%1: %2").arg(what, QString::fromLocal8Bit(strerror(errno)));
+}
+
+bool TrafficGenerator::start(Pattern pattern, qint64 bytesPerSec)
+{
+    stop();
+    error_.clear();
+    pattern_ = pattern;
+    seq_ = 0;
+    setRate(bytesPerSec);
+    written_.store(0);
+    lag_.store(0);
+    stalls_.store(0);
+
+    masterFd_ = posix_openpt(O_RDWR | O_NOCTTY);
+    if (masterFd_ < 0) {
+        fail("posix_openpt");
+        return false;
+    }
+    if (grantpt(masterFd_) != 0 || unlockpt(masterFd_) != 0) {
+        fail("pty");
+        stop();
+        return false;
+    }
+    char name[128];
+    if (ptsname_r(masterFd_, name, sizeof(name)) != 0) {
+        fail("ptsname");
+        stop();
+        return false;
+    }
+    slavePath_ = QString::fromLocal8Bit(name);
+
+    // Raw slave so the line discipline passes bytes through untouched
+    slaveFd_ = ::open(name, O_RDWR | O_NOCTTY | O_CLOEXEC);
+    if (slaveFd_ < 0) {
+        fail(slavePath_);
+        stop();
+        return false;
+    }
+    termios tio;
+    if (tcgetattr(slaveFd_, &tio) == 0) {
+        cfmakeraw(&tio);
+        tcsetattr(slaveFd_, TCSANOW, &tio);
+    }
+    fcntl(masterFd_, F_SETFL, fcntl(masterFd_, F_GETFL) | O_NONBLOCK);
+
+    stop_.store(false);
+    writer_ = QThread::create([this]() { writeLoop(); });
+    writer_->setObjectName("TrafficGenerator");
+    writer_->start(QThread::HighPriority);
+    return true;
+}
+
+void TrafficGenerator::stop()
+{
+    if (writer_) {
+        stop_.store(true);
+        writer_->wait();
+        delete writer_;
+        writer_ = nullptr;
+    }
+    if (slaveFd_ >= 0)
+        ::close(slaveFd_);
+    if (masterFd_ >= 0)
+        ::close(masterFd_);
+    slaveFd_ = masterFd_ = -1;
+}
+
+void TrafficGenerator::writeLoop()
+{
+    const qint64 kTickNs = 1000000;                // 1 ms pacing tick
+    const qint64 kBurstNs = 100 * 1000000LL;
+    const qint64 kMaxPerTick = 1024 * 1024;
+    QByteArray pending;                            // generated, not yet written
+    int pendingPos = 0;
+    char discard[4096];
+
+    // The schedule is piecewise linear: rate changes start a new segment
+    qint64 segmentStartNs = SerialWorker::monotonicNs();
+    qint64 segmentStartBytes = 0;
+    qint64 segmentRate = rate_.load();
+    qint64 written = 0;
+
+    timespec next;
+    clock_gettime(CLOCK_MONOTONIC, &next);
+
+    while (!stop_.load()) {
+        const qint64 now = SerialWorker::monotonicNs();
+        const qint64 rate = rate_.load();
+        if (rate != segmentRate) {
+            segmentStartBytes += qint64(double(segmentRate) * double(now - segmentStartNs) / 1e9);
+            segmentStartNs = now;
+            segmentRate = rate;
+        }
+        qint64 elapsedNs = now - segmentStartNs;
+        if (pattern_ == Pattern::Burst)
+            elapsedNs -= elapsedNs % kBurstNs;     // release whole bursts only
+        const qint64 target = segmentStartBytes + qint64(double(segmentRate) * double(elapsedNs) / 1e9);
+
+        qint64 owed = qMin(target - written, kMaxPerTick);
+        if (owed > 0) {
+            if (pending.size() - pendingPos < owed) {
+                pending.remove(0, pendingPos);
+                pendingPos = 0;
+                generate(pending, owed - pending.size());
+            }
+            while (owed > 0) {
+                ssize_t w = ::write(masterFd_, pending.constData() + pendingPos, size_t(owed));
+                if (w > 0) {
+                    pendingPos += int(w);
+                    written += w;
+                    owed -= w;
+                    continue;
+                }
+                if (w < 0 && errno == EINTR)
+                    continue;
+                if (w < 0 && errno == EAGAIN)
+                    stalls_.fetch_add(1, std::memory_order_relaxed);
+                break;
+            }
+            written_.store(quint64(written));
+        }
+        lag_.store(qMax<qint64>(0, target - written));
+
+        // Throw away whatever the app sends so its TX never blocks
+        while (::read(masterFd_, discard, sizeof(discard)) > 0) {
+        }
+
+        next.tv_nsec += kTickNs;
+        if (next.tv_nsec >= 1000000000) {
+            next.tv_nsec -= 1000000000;
+            ++next.tv_sec;
+        }
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, nullptr);
+    }
+}
+
+#else // !Q_OS_LINUX
+
+void TrafficGenerator::fail(const QString &what)
+{
+    error_ = what;
+}
+
+bool TrafficGenerator::start(Pattern, qint64)
+{
+    error_ = "The traffic generator is only available on Linux";
+    return false;
+}
+
+void TrafficGenerator::stop()
+{
+}
+
+void TrafficGenerator::writeLoop()
+{
+}
+
+#endif
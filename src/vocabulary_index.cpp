@@ -0,0 +1,105 @@
+#include "vocabulary_index.h"
+#include <algorithm>
+#include <vector>
+
+namespace {
+
+inline bool isWordByte(uchar c)
+{
+    return c >= 0x80 || c == '_' || (c >= '0' && c <= '9') || ((c | 0x20) >= 'a' && (c | 0x20) <= 'z');
+}
+
+QByteArray asciiLower(const char *data, int size)
+{
+    QByteArray out(data, size);
+    for (char &c : out) {
+        if (c >= 'A' && c <= 'Z')
+            c = char(c | 0x20);
+    }
+    return out;
+}
+
+} // namespace
+
+void VocabularyIndex::addUtf8(const char *data, int size)
+{
+    const char *end = data + size;
+    const char *p = data;
+    if (!partial_.isEmpty()) {
+        while (p < end && isWordByte(uchar(*p)))
+            ++p;
+        if (p == end) {
+            // Still inside the same word; stop collecting once it is too long to count
+            if (partial_.size() <= kMaxWordLength)
+                partial_.append(data, int(qMin<qint64>(end - data, kMaxWordLength + 1)));
+            return;
+        }
+        partial_.append(data, int(qMin<qint64>(p - data, kMaxWordLength + 1)));
+        addWord(partial_.constData(), partial_.size());
+        partial_.clear();
+    }
+
+    while (p < end) {
+        while (p < end && !isWordByte(uchar(*p)))
+            ++p;
+        const char *start = p;
+        while (p < end && isWordByte(uchar(*p)))
+            ++p;
+        if (p == end) {
+            partial_ = QByteArray(start, int(qMin<qint64>(p - start, kMaxWordLength + 1)));
+            return;
+        }
+        addWord(start, int(p - start));
+    }
+}
+
+void VocabularyIndex::addWord(const char *word, int size)
+{
+    if (size <= 0 || size > kMaxWordLength)
+        return;
+    const QByteArray key = asciiLower(word, size);
+    auto it = words_.find(key);
+    if (it == words_.end()) {
+        if (int(words_.size()) >= kMaxWords)
+            return;
+        it = words_.emplace(key, Entry()).first;
+        it->second.word = QByteArray(word, size);
+    }
+    ++it->second.count;
+}
+
+void VocabularyIndex::clear()
+{
+    words_.clear();
+    partial_.clear();
+}
+
+QStringList VocabularyIndex::topMatches(const QString &prefix, int count) const
+{
+    QStringList out;
+    if (count <= 0 || prefix.size() < kMinPrefix)
+        return out;
+    const QByteArray utf8 = prefix.toUtf8();
+    const QByteArray key = asciiLower(utf8.constData(), utf8.size());
+
+    // Keep the best count entries of the prefix range, so a keystroke costs
+    // at most kMaxScan steps however many words share the prefix
+    auto worse = [](const Entry *a, const Entry *b) { return a->count > b->count; };
+    std::vector<const Entry *> best;
+    int scanned = 0;
+    for (auto it = words_.lower_bound(key);
+         it != words_.end() && scanned < kMaxScan && it->first.startsWith(key); ++it, ++scanned) {
+        if (int(best.size()) < count) {
+            best.push_back(&it->second);
+            std::push_heap(best.begin(), best.end(), worse);
+        } else if (it->second.count > best.front()->count) {
+            std::pop_heap(best.begin(), best.end(), worse);
+            best.back() = &it->second;
+            std::push_heap(best.begin(), best.end(), worse);
+        }
+    }
+    std::sort_heap(best.begin(), best.end(), worse);
+    for (const Entry *e : best)
+        out.append(QString::fromUtf8(e->word));
+    return out;
+}
@@ -0,0 +1,227 @@
+// NativeSerialPort against a pseudo-terminal pair: the port opens the slave
+// side and the test plays the device on the master side.
+//
+// Exits non-zero if a check fails.
+
+#include "native_serial_port.h"
+#include <QByteArray>
+#include <QDeadlineTimer>
+#include <QMutex>
+#include <QWaitCondition>
+#include <cstdio>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+namespace {
+
+int failures = 0;
+
+void check(bool ok, const char *what)
+{
+    std::printf("%s: %s\n", ok ? "PASS" : "FAIL", what);
+    if (!ok)
+        ++failures;
+}
+
+// What the reader thread handed over
+struct Received {
+    QMutex mutex;
+    QWaitCondition changed;
+    QByteArray data;
+    int reads = 0;
+    QString error;
+
+    // Until data holds size bytes or an error came, or timeoutMs passes
+    bool waitFor(int size, int timeoutMs)
+    {
+        QDeadlineTimer deadline(timeoutMs);
+        QMutexLocker lock(&mutex);
+        while (data.size() < size && error.isEmpty()) {
+            if (!changed.wait(&mutex, deadline))
+                break;
+        }
+        return data.size() >= size;
+    }
+    bool waitForError(int timeoutMs)
+    {
+        QDeadlineTimer deadline(timeoutMs);
+        QMutexLocker lock(&mutex);
+        while (error.isEmpty()) {
+            if (!changed.wait(&mutex, deadline))
+                break;
+        }
+        return !error.isEmpty();
+    }
+    int readCount()
+    {
+        QMutexLocker lock(&mutex);
+        return reads;
+    }
+    int size()
+    {
+        QMutexLocker lock(&mutex);
+        return data.size();
+    }
+};
+
+// The master side of a fresh pty pair, and the slave's path
+struct Pty {
+    int master = -1;
+    QString slave;
+
+    bool open()
+    {
+        master = posix_openpt(O_RDWR | O_NOCTTY);
+        if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0)
+            return false;
+        slave = QString::fromLocal8Bit(ptsname(master));
+        return true;
+    }
+    void close()
+    {
+        if (master >= 0)
+            ::close(master);
+        master = -1;
+    }
+    ~Pty() { close(); }
+
+    bool write(const char *data)
+    {
+        const ssize_t len = ssize_t(strlen(data));
+        return ::write(master, data, size_t(len)) == len;
+    }
+    // What the port sent, waiting up to timeoutMs for size bytes
+    QByteArray read(int size, int timeoutMs)
+    {
+        QByteArray out;
+        QDeadlineTimer deadline(timeoutMs);
+        while (out.size() < size && !deadline.hasExpired()) {
+            pollfd pfd{master, POLLIN, 0};
+            if (poll(&pfd, 1, int(deadline.remainingTime())) <= 0)
+                break;
+            char buf[256];
+            const ssize_t r = ::read(master, buf, sizeof(buf));
+            if (r <= 0)
+                break;
+            out.append(buf, int(r));
+        }
+        return out;
+    }
+};
+
+bool openPort(NativeSerialPort &port, const Pty &pty, const NativeSerialPort::Options &opts, Received &rx)
+{
+    const bool ok = port.open(
+        pty.slave, 115200, opts,
+        [&rx](const char *data, qint64 len) {
+            QMutexLocker lock(&rx.mutex);
+            rx.data.append(data, int(len));
+            ++rx.reads;
+            rx.changed.wakeAll();
+        },
+        [&rx](const QString &msg) {
+            QMutexLocker lock(&rx.mutex);
+            rx.error = msg;
+            rx.changed.wakeAll();
+        });
+    if (!ok)
+        std::printf("open %s: %s\n", qPrintable(pty.slave), qPrintable(port.errorString()));
+    return ok;
+}
+
+void testReadWrite()
+{
+    Pty pty;
+    Received rx;
+    NativeSerialPort port;
+    check(pty.open(), "pty pair opens");
+    if (!openPort(port, pty, NativeSerialPort::Options(), rx)) {
+        check(false, "port opens on the pty slave");
+        return;
+    }
+    check(port.isOpen(), "port opens on the pty slave");
+
+    pty.write("hello\n");
+    check(rx.waitFor(6, 1000) && rx.data == "hello\n", "bytes from the device are read");
+
+    check(port.writeSome("ping", 4) == 4, "writeSome takes the bytes");
+    check(pty.read(4, 1000) == "ping", "written bytes reach the device");
+
+    port.close();
+    check(!port.isOpen(), "port closes");
+}
+
+void testVminTail()
+{
+    // A burst shorter than VMIN, with VTIME 0, still goes out once the line is quiet
+    {
+        Pty pty;
+        Received rx;
+        NativeSerialPort port;
+        NativeSerialPort::Options opts;
+        opts.vmin = 8;
+        opts.vtime = 0;
+        if (!pty.open() || !openPort(port, pty, opts, rx)) {
+            check(false, "port opens with VMIN 8 VTIME 0");
+            return;
+        }
+        pty.write("abc");
+        check(rx.waitFor(3, 500) && rx.data == "abc", "VMIN 8 VTIME 0: a 3-byte tail is delivered");
+        check(rx.readCount() == 1, "VMIN 8 VTIME 0: the tail is delivered in one piece");
+
+        pty.write("0123456789");
+        check(rx.waitFor(13, 500), "VMIN 8 VTIME 0: a burst longer than VMIN is delivered");
+    }
+
+    // With VTIME the tail waits for that gap, then goes out
+    {
+        Pty pty;
+        Received rx;
+        NativeSerialPort port;
+        NativeSerialPort::Options opts;
+        opts.vmin = 8;
+        opts.vtime = 3;
+        if (!pty.open() || !openPort(port, pty, opts, rx)) {
+            check(false, "port opens with VMIN 8 VTIME 3");
+            return;
+        }
+        pty.write("xy");
+        usleep(100 * 1000);
+        check(rx.size() == 0, "VMIN 8 VTIME 3: a 2-byte tail is held within the gap");
+        check(rx.waitFor(2, 1000) && rx.data == "xy", "VMIN 8 VTIME 3: the tail is delivered after the gap");
+    }
+}
+
+void testHangUp()
+{
+    Pty pty;
+    Received rx;
+    NativeSerialPort port;
+    NativeSerialPort::Options opts;
+    opts.vmin = 8;
+    if (!pty.open() || !openPort(port, pty, opts, rx)) {
+        check(false, "port opens for the hang-up test");
+        return;
+    }
+    pty.write("bye");
+    usleep(1000);
+    // The device goes away: the held bytes come first, then the error
+    pty.close();
+    check(rx.waitForError(1000), "hang-up is reported");
+    check(rx.size() == 3, "bytes received before the hang-up are delivered");
+    port.close();
+    check(!port.isOpen(), "port closes after a hang-up");
+}
+
+} // namespace
+
+int main()
+{
+    testReadWrite();
+    testVminTail();
+    testHangUp();
+    std::printf("%s\n", failures ? "FAILED" : "All tests passed");
+    return failures ? 1 : 0;
+}